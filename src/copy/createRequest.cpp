@@ -5,8 +5,11 @@
 
 #include <string>
 #include <sstream>
+#include <algorithm>
+#include <map>
 
 #include <epicsMutex.h>
+#include <epicsThread.h>
 
 #define epicsExportSharedSymbols
 
@@ -30,15 +33,6 @@ static FieldCreatePtr fieldCreate = getFieldCreate();
 
 struct CreateRequestImpl {
 
-    struct Node
-    {
-        string name;
-        vector<Node> nodes;
-        Node(string name)
-        : name(name)
-        {}
-    };
-
     struct OptionPair
     {
          string name;
@@ -53,260 +47,170 @@ struct CreateRequestImpl {
     vector<OptionPair> optionList;
     string fullFieldName;
 
+    // field offset and value of each option in the result
+    typedef vector<std::pair<size_t, string> > values_t;
+    values_t optionValues;
 
-    CreateRequestImpl() {}
+    // remaining input of the field list being parsed
+    const char *pos, *end;
 
+    // for field names without options or sub-fields
+    const StructureConstPtr emptyStructure;
 
-    void removeBlanks(string& str)
+    CreateRequestImpl() :pos(0), end(0), emptyStructure(fieldCreate->createStructure()) {}
+
+
+    static void removeBlanks(string& str)
     {
-        while(true) {
-            string::size_type pos = str.find_first_of(' ');
-            if(pos==string::npos) return;
-            str.erase(pos,1);
-        }
+        str.erase(std::remove(str.begin(), str.end(), ' '), str.end());
     }
 
-    size_t findMatchingBrace(string& request, size_t index, int numOpen) {
-        size_t openBrace = request.find('{', index+1);
-        size_t closeBrace = request.find('}', index+1);
-        if(openBrace == string::npos && closeBrace == string::npos){
-             throw std::runtime_error(request + " mismatched {}");
-        }
-        if (openBrace != string::npos && openBrace!=0) {
-            if(openBrace<closeBrace) return findMatchingBrace(request,openBrace,numOpen+1);
-            if(numOpen==1) return closeBrace;
-            return findMatchingBrace(request,closeBrace,numOpen-1);
-        }
-        if(numOpen==1) return closeBrace;
-        return findMatchingBrace(request,closeBrace,numOpen-1);
+    // characters which end a field name
+    static bool isNameEnd(char c)
+    {
+        return c=='[' || c=='.' || c=='{' || c==',' || c=='}';
     }
 
-    size_t findMatchingBracket(string& request, size_t index) {
-        for(size_t i=index+1; i< request.size(); ++i) {
-            if(request[i] == ']') {
-                if(i==index+1) {
-                     throw std::runtime_error(request + " mismatched []");
-                }
-                return i;
-            }
+    StructureConstPtr createRequestOptions(const char *first, const char *last)
+    {
+        if(last-first<=1) {
+            throw std::runtime_error("logic error empty options");
         }
-        throw std::runtime_error(request + " missing ]");
-    }
+        const char *begin = first;
+        StringArray names;
 
-    size_t findEndField(string& request) {
-        size_t ind = 0;
-        size_t maxind = request.size() -1;
         while(true) {
-             if(request[ind]==',') return ind;
-             if(request[ind]=='[') {
-                 size_t closeBracket = findMatchingBracket(request,ind);
-                 if(closeBracket==string::npos) return closeBracket;
-                 ind = closeBracket;
-                 continue;
-             }
-             if(request[ind]=='{') {
-                 size_t closeBrace = findMatchingBrace(request,ind,1);
-                 if(closeBrace==string::npos) return closeBrace;
-                 if(ind>=request.size()) return request.size();
-                 ind = closeBrace;
-                 continue;
-             }
-             if(request[ind]=='.') {
-                 ++ind;
-                 continue;
-             }
-             if(ind>=maxind) break;
-             ++ind;
+            const char *sep = std::find(first, last, ',');
+            const char *equals = std::find(first, sep, '=');
+            if(equals==sep || equals==first) {
+                throw std::runtime_error(string(first, sep) + " illegal option " + string(begin, last));
+            }
+            string name(first, equals);
+            optionList.push_back(OptionPair(fullFieldName + "._options." + name,
+                                            string(equals+1, sep)));
+            names.push_back(name);
+            if(sep==last)
+                break;
+            first = sep+1;
         }
-        return request.size();
-    }
 
-    vector<string> split(string const & commaSeparatedList) {
-        string::size_type numValues = 1;
-        string::size_type index=0;
-        while(true) {
-            string::size_type pos = commaSeparatedList.find(',',index);
-            if(pos==string::npos) break;
-            numValues++;
-            index = pos +1;
-        }
-        vector<string> valueList(numValues,"");
-        index=0;
-        for(size_t i=0; i<numValues; i++) {
-            size_t pos = commaSeparatedList.find(',',index);
-            string value = commaSeparatedList.substr(index,pos-index);
-            valueList[i] = value;
-            index = pos +1;
-        }
-        return valueList;
+        FieldConstPtrArray fields(names.size(), fieldCreate->createScalar(pvString));
+        return fieldCreate->createStructure(names, fields);
     }
 
-    Node createRequestOptions(
-        string const & request)
+    // comma separated list of fields, up to the end of input or an enclosing '}'
+    void parseList(StringArray& names, FieldConstPtrArray& fields, bool nested)
     {
-        if(request.length()<=1) {
-            throw std::runtime_error("logic error empty options");
-        }
-        vector<Node> top;
-        vector<string> items = split(request);
-
-        size_t nitems = items.size();
-        for(size_t j=0; j<nitems; j++) {
-            string item = items[j];
-            size_t equals = item.find('=');
-            if(equals==string::npos || equals==0) {
-                throw std::runtime_error(item + " illegal option " + request);
+        while(true) {
+            bool compound = parseField(names, fields);
+
+            if(pos==end) {
+                if(nested)
+                    throw std::runtime_error("mismatched {}");
+                return;
+            } else if(*pos==',') {
+                pos++;
+                // as before, allow a trailing ',' after a.b or a{b}
+                if(compound && (pos==end || (nested && *pos=='}')))
+                    return;
+            } else if(*pos=='}' && nested) {
+                return;
+            } else if(*pos=='}') {
+                throw std::runtime_error("mismatched {}");
+            } else {
+                // as before, a malformed field name
+                throw std::invalid_argument("illegal syntax " + string(pos, end));
             }
-            top.push_back(Node(item.substr(0,equals)));
-            string name = fullFieldName + "._options." + item.substr(0,equals);
-            string value = item.substr(equals+1);
-            optionList.push_back(OptionPair(name,value));
         }
-        Node node("_options");
-        node.nodes = top;
-        return node;
     }
 
-
-    void createSubNode(Node &node,string const & crequest)
+    // name[options].sub  name[options]{list}  or  name[options]
+    // returns true for the first two forms
+    bool parseField(StringArray& names, FieldConstPtrArray& fields)
     {
-        string request = crequest;
-        size_t end = 0;
-        for(size_t i=0; i<request.size(); ++i) {
-            if(request[i]=='[') { end = i; break;}
-            if(request[i]=='.') { end = i; break;}
-            if(request[i]=='{') { end = i; break;}
-            if(request[i]==',') { end = i; break;}
-        }
-        char chr = request[end];
-        Node optionNode("");
-        if(chr=='[') {
+        const char *first = pos;
+        while(pos!=end && !isNameEnd(*pos))
+            pos++;
+        string name(first, pos);
+
+        StringArray subNames;
+        FieldConstPtrArray subFields;
+
+        if(pos!=end && *pos=='[') {
+            const char *close = std::find(pos+1, end, ']');
+            if(close==end) {
+                throw std::runtime_error(string(first, end) + " missing ]");
+            } else if(close==pos+1) {
+                throw std::runtime_error(string(first, end) + " mismatched []");
+            }
             string saveFullName = fullFieldName;
-            fullFieldName += "." + request.substr(0,end);
-            size_t endBracket = findMatchingBracket(request,end);
-            string options = request.substr(end+1,endBracket -end -1);
-            optionNode = createRequestOptions(options);
+            fullFieldName += "." + name;
+            subNames.push_back("_options");
+            subFields.push_back(createRequestOptions(pos+1, close));
             fullFieldName = saveFullName;
-            size_t next = endBracket+1;
-            if(next<request.size()) {
-                request = request.substr(0, end) + request.substr(endBracket+1);
-            } else {
-                request = request.substr(0, end);
-            }
-            end = 0;
-            for(size_t i=0; i<request.size(); ++i) {
-                if(request[i]=='.') { end = i; break;}
-                if(request[i]=='{') { end = i; break;}
-                if(request[i]==',') { end = i; break;}
-            }
-            chr = request[end];
+
+            // as before, any characters following ']' are appended to the name
+            pos = close+1;
+            first = pos;
+            while(pos!=end && !isNameEnd(*pos))
+                pos++;
+            name.append(first, pos);
         }
-        if(end==0) end = request.size();
-        string name = request.substr(0,end);
-        if(name.size()<1) {
-            throw std::runtime_error("null field name " + request);
+        if(name.empty() && pos==end) {
+            throw std::runtime_error("null field name " + string(first, end));
+        } else if(name.empty()) {
+            // as before, a malformed field name
+            throw std::invalid_argument("null field name " + string(first, end));
         }
+
         string saveFullName = fullFieldName;
         fullFieldName += "." + name;
-        if(end==request.size()) {
-            Node subNode(name);
-            if(optionNode.name.size()>0) subNode.nodes.push_back(optionNode);
-            node.nodes.push_back(subNode);
-            fullFieldName = saveFullName;
-            return;
-        }
-        if(chr==',') {
-            Node subNode(name);
-            if(optionNode.name.size()>0) subNode.nodes.push_back(optionNode);
-            node.nodes.push_back(subNode);
-            string rest = request.substr(end+1);
-            fullFieldName = saveFullName;
-            createSubNode(node,rest);
-            return;
-        }
-        if(chr=='.') {
-            request = request.substr(end+1);
-            if(request.size()==string::npos || request.size()<1) {
-                throw std::runtime_error("null field name " + request);
-            }
-            Node subNode(name);
-            if(optionNode.name.size()>0) subNode.nodes.push_back(optionNode);
-            size_t endField = findEndField(request);
-            string subRequest = request.substr(0, endField);
-            createSubNode(subNode,subRequest);
-            node.nodes.push_back(subNode);
-            size_t next = endField+1;
-            if(next>=request.size()) {
-                fullFieldName = saveFullName;
-                return;
-            }
-            request = request.substr(next);
-            fullFieldName = saveFullName;
-            createSubNode(node,request);
-            return;
-        }
-        if(chr=='{') {
-            size_t endBrace = findEndField(request);
-            if((end+1)>=(endBrace-1)) {
-                throw std::runtime_error("illegal syntax " + request);
-            }
-            string subRequest = request.substr(end+1,endBrace-1 -end -1);
-            if(subRequest.size()<1) {
-                throw std::runtime_error("empty {} " + request);
-            }
-            Node subNode(name);
-            if(optionNode.name.size()>0) subNode.nodes.push_back(optionNode);
-            createSubNode(subNode,subRequest);
-            node.nodes.push_back(subNode);
-            size_t next = endBrace + 1;
-            if(next>=request.size()) {
-                fullFieldName = saveFullName;
-                return;
-            }
-            request = request.substr(next);
-            fullFieldName = saveFullName;
-            createSubNode(node,request);
-            return;
-        }
-        throw std::runtime_error("logic error");
-    }
+        bool compound = true;
 
-    FieldConstPtr createSubStructure(vector<Node> & nodes)
-    {
-        size_t num = nodes.size();
-        StringArray names(num);
-        FieldConstPtrArray fields(num);
-        for(size_t i=0; i<num; ++i) {
-            Node node = nodes[i];
-            names[i] = node.name;
-            if(node.name.compare("_options")==0) {
-                fields[i] = createOptions(node.nodes);
-            } else {
-                vector<Node> subNode = node.nodes;
-                if(subNode.empty()) {
-                    fields[i] = fieldCreate->createStructure();
-                } else {
-                    fields[i] = createSubStructure(subNode);
-                }
+        if(pos!=end && *pos=='.') {
+            pos++;
+            parseField(subNames, subFields);
+
+        } else if(pos!=end && *pos=='{') {
+            pos++;
+            if(pos==end || *pos=='}') {
+                throw std::runtime_error("illegal syntax " + name + "{}");
             }
+            parseList(subNames, subFields, true);
+            pos++; // skip '}'
+
+        } else {
+            compound = false;
         }
-        StructureConstPtr structure = fieldCreate->createStructure(
-            names, fields);
-        return structure;
+
+        fullFieldName = saveFullName;
+
+        names.push_back(name);
+        if(subNames.empty())
+            fields.push_back(emptyStructure);
+        else
+            fields.push_back(fieldCreate->createStructure(subNames, subFields));
+        return compound;
     }
 
-    StructureConstPtr createOptions(vector<Node> &nodes)
+    // the content of field(), getField() or putField()
+    StructureConstPtr createFieldList(const string& request, size_t offset, const char *what)
     {
-        size_t num = nodes.size();
-        StringArray names(num);
-        FieldConstPtrArray fields(num);
-        for(size_t i=0; i<num; ++i) {
-            Node node = nodes[i];
-            names[i] = node.name;
-            fields[i] = fieldCreate->createScalar(pvString);
+        fullFieldName = what;
+        size_t openParan = request.find('(', offset);
+        size_t closeParan = request.find(')', openParan);
+        if(closeParan==string::npos) {
+            throw std::runtime_error(request.substr(offset)
+                    + " " + what + "( does not have matching )");
         }
-        StructureConstPtr structure = fieldCreate->createStructure(names, fields);
-        return structure;
+        StringArray names;
+        FieldConstPtrArray fields;
+        if(closeParan>openParan+1) {
+            pos = request.c_str()+openParan+1;
+            end = request.c_str()+closeParan;
+            parseList(names, fields, false);
+        }
+        return fieldCreate->createStructure(names, fields);
     }
 
 
@@ -336,13 +240,14 @@ struct CreateRequestImpl {
             int numBrace = 0;
             int numBracket = 0;
             for(size_t i=0; i< request.length() ; ++i) {
-                char chr = request[i];
-                if(chr=='(') numParan++;
-                if(chr==')') numParan--;
-                if(chr=='{') numBrace++;
-                if(chr=='}') numBrace--;
-                if(chr=='[') numBracket++;
-                if(chr==']') numBracket--;
+                switch(request[i]) {
+                case '(': numParan++; break;
+                case ')': numParan--; break;
+                case '{': numBrace++; break;
+                case '}': numBrace--; break;
+                case '[': numBracket++; break;
+                case ']': numBracket--; break;
+                }
             }
             if(numParan!=0) {
                 ostringstream oss;
@@ -359,7 +264,8 @@ struct CreateRequestImpl {
                 oss << "mismatched [] " << numBracket;
                 throw std::runtime_error(oss.str());
             }
-            vector<Node> top;
+            StringArray names;
+            FieldConstPtrArray fields;
             try {
                 if(offsetRecord!=string::npos) {
                     fullFieldName = "record";
@@ -370,81 +276,39 @@ struct CreateRequestImpl {
                             "record[ does not have matching ]");
                     }
                     if(closeBracket-openBracket > 3) {
-                        Node node("record");
-                        Node optNode = createRequestOptions(
-                                request.substr(openBracket+1,closeBracket-openBracket-1));
-                        node.nodes.push_back(optNode);
-                        top.push_back(node);
+                        StringArray optNames(1, "_options");
+                        FieldConstPtrArray optFields(1, createRequestOptions(request.c_str()+openBracket+1,
+                                                                             request.c_str()+closeBracket));
+                        names.push_back("record");
+                        fields.push_back(fieldCreate->createStructure(optNames, optFields));
                     }
                 }
                 if(offsetField!=string::npos) {
-                    fullFieldName = "field";
-                    Node node("field");
-                    size_t openParan = request.find('(', offsetField);
-                    size_t closeParan = request.find(')', openParan);
-                    if(closeParan==string::npos) {
-                        throw std::runtime_error(request.substr(offsetField)
-                                + " field( does not have matching )");
-                    }
-                    if(closeParan>openParan+1) {
-                        createSubNode(node,request.substr(openParan+1,closeParan-openParan-1));
-                    }
-                    top.push_back(node);
+                    names.push_back("field");
+                    fields.push_back(createFieldList(request, offsetField, "field"));
                 }
                 if(offsetGetField!=string::npos) {
-                    fullFieldName = "getField";
-                    Node node("getField");
-                    size_t openParan = request.find('(', offsetGetField);
-                    size_t closeParan = request.find(')', openParan);
-                    if(closeParan==string::npos) {
-                        throw std::runtime_error(request.substr(offsetField)
-                                + " getField( does not have matching )");
-                    }
-                    if(closeParan>openParan+1) {
-                        createSubNode(node,request.substr(openParan+1,closeParan-openParan-1));
-                    }
-                    top.push_back(node);
+                    names.push_back("getField");
+                    fields.push_back(createFieldList(request, offsetGetField, "getField"));
                 }
                 if(offsetPutField!=string::npos) {
-                    fullFieldName = "putField";
-                    Node node("putField");
-                    size_t openParan = request.find('(', offsetPutField);
-                    size_t closeParan = request.find(')', openParan);
-                    if(closeParan==string::npos) {
-                        throw std::runtime_error(request.substr(offsetField)
-                                + " putField( does not have matching )");
-                    }
-                    if(closeParan>openParan+1) {
-                        createSubNode(node,request.substr(openParan+1,closeParan-openParan-1));
-                    }
-                    top.push_back(node);
+                    names.push_back("putField");
+                    fields.push_back(createFieldList(request, offsetPutField, "putField"));
                 }
+            } catch (std::invalid_argument&) {
+                throw; // malformed field name.  or from FieldCreate, eg. duplicate field name
             } catch (std::exception &e) {
                 throw std::runtime_error(std::string("while creating Structure exception ")+e.what());
             }
-            size_t num = top.size();
-            StringArray names(num);
-            FieldConstPtrArray fields(num);
-            for(size_t i=0; i<num; ++i) {
-                Node node = top[i];
-                names[i] = node.name;
-                vector<Node> subNode = node.nodes;
-                if(subNode.empty()) {
-                    fields[i] = fieldCreate->createStructure();
-                } else {
-                    fields[i] = createSubStructure(subNode);
-                }
-            }
             StructureConstPtr structure = fieldCreate->createStructure(names, fields);
             if(!structure) throw std::invalid_argument("bad request " + crequest);
             PVStructurePtr pvStructure = structure->build();
             for(size_t i=0; i<optionList.size(); ++i) {
-                OptionPair pair = optionList[i];
-                string name = pair.name;
-                string value = pair.value;
-                PVStringPtr pvField = pvStructure->getSubField<PVString>(name);
+                const OptionPair& pair = optionList[i];
+                PVStringPtr pvField = pvStructure->getSubField<PVString>(pair.name);
                 if(!pvField) throw std::invalid_argument("bad request " + crequest);
-                pvField->put(value);
+                pvField->put(pair.value);
+                optionValues.push_back(std::make_pair(pvField->getFieldOffset(), pair.value));
             }
             optionList.clear();
             return pvStructure;
@@ -454,6 +318,35 @@ struct CreateRequestImpl {
 
 };
 
+// Clients often send identical requests.  eg. on reconnect.
+// So remember recently parsed requests.
+struct RequestCache {
+    // arbitrary limit.  Cleared when reached.
+    static const size_t maxEntries = 256u;
+
+    struct Entry {
+        StructureConstPtr type;
+        CreateRequestImpl::values_t options;
+    };
+
+    epicsMutex lock;
+    typedef std::map<string, std::tr1::shared_ptr<const Entry> > entries_t;
+    entries_t entries;
+} *requestCache;
+
+void requestCacheInit(void *)
+{
+    requestCache = new RequestCache;
+}
+
+epicsThreadOnceId requestCacheOnce = EPICS_THREAD_ONCE_INIT;
+
+RequestCache& getRequestCache()
+{
+    epicsThreadOnce(&requestCacheOnce, &requestCacheInit, 0);
+    return *requestCache;
+}
+
 } // namespace
 
 namespace epics {namespace pvData {
@@ -477,8 +370,36 @@ PVStructure::shared_pointer CreateRequest::createRequest(std::string const & req
 
 PVStructure::shared_pointer createRequest(std::string const & request)
 {
+    RequestCache& cache = getRequestCache();
+    std::tr1::shared_ptr<const RequestCache::Entry> entry;
+    {
+        Lock G(cache.lock);
+        RequestCache::entries_t::const_iterator it(cache.entries.find(request));
+        if(it!=cache.entries.end())
+            entry = it->second;
+    }
+
+    if(entry) {
+        PVStructurePtr ret(entry->type->build());
+        for(size_t i=0, N=entry->options.size(); i<N; i++) {
+            static_cast<PVString&>(*ret->getSubFieldT(entry->options[i].first)).put(entry->options[i].second);
+        }
+        return ret;
+    }
+
+    // parse outside of lock.  errors are not cached.
     CreateRequestImpl I;
-    return I.createRequest(request);
+    PVStructurePtr ret(I.createRequest(request));
+
+    std::tr1::shared_ptr<RequestCache::Entry> added(new RequestCache::Entry);
+    added->type = ret->getStructure();
+    added->options.swap(I.optionValues);
+
+    Lock G(cache.lock);
+    if(cache.entries.size()>=RequestCache::maxEntries)
+        cache.entries.clear();
+    cache.entries[request] = added;
+    return ret;
 }
 
 
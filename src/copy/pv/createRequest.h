@@ -69,7 +69,9 @@ PVStructure::shared_pointer createRequest(std::string const & request);
  *  'field' substructure of a pvRequest.
  *  Copies between an internal (base) Structure, and a client/user visible (requested) Structure.
  *
- * @note PVRequestMapper is not re-entrant.  It is copyable and swap()able.
+ * @note PVRequestMapper is copyable and swap()able.
+ *       The const methods may be called concurrently, which allows
+ *       a computed mapping to be shared between threads.  eg. through the cache of lookup().
  */
 class epicsShareClass PVRequestMapper {
 public:
@@ -158,6 +160,19 @@ public:
             BitSet& requestMask
     ) const;
 
+    /** As copyBaseToRequested(), with caller provided working storage.
+     *
+     * @param scratch Overwritten.  Re-using a BitSet avoids allocations for large Structures.
+     * @version Added after 8.0.5
+     */
+    void copyBaseToRequested(
+            const PVStructure& base,
+            const BitSet& baseMask,
+            PVStructure& request,
+            BitSet& requestMask,
+            BitSet& scratch
+    ) const;
+
     /** Copy field values into Base structure from Requested structure
      *
      * @param base An instance of the base Structure.  Field values are copied into it.
@@ -174,6 +189,19 @@ public:
             const BitSet& requestMask
     ) const;
 
+    /** As copyBaseFromRequested(), with caller provided working storage.
+     *
+     * @param scratch Overwritten.  Re-using a BitSet avoids allocations for large Structures.
+     * @version Added after 8.0.5
+     */
+    void copyBaseFromRequested(
+            PVStructure& base,
+            BitSet& baseMask,
+            const PVStructure& request,
+            const BitSet& requestMask,
+            BitSet& scratch
+    ) const;
+
     //! Translate Base bit mask into requested bit mask.
     //! BitSet::clear() is not called.
     inline void maskBaseToRequested(
@@ -193,6 +221,27 @@ public:
     //! Exchange contents of two mappers.  O(0) and never throws.
     void swap(PVRequestMapper& other);
 
+    /** Find or compute() a mapping in a process-wide cache.
+     *
+     * Mappings are shared between all callers which use the same base Structure,
+     * mode, and an equivalent pvRequest.
+     * Two pvRequests are equivalent if their 'field' sub-structures select the same
+     * fields, and their 'record._options.keepIDs' values are the same.
+     * Other options do not affect the mapping, and are ignored.
+     *
+     * An entry is kept only while some caller holds a reference to the returned mapping.
+     *
+     * @throws std::runtime_error as compute().  Failures are not cached.
+     * @version Added after 8.0.5
+     */
+    static std::tr1::shared_ptr<const PVRequestMapper> lookup(const PVStructure& base,
+                                                              const PVStructure& pvRequest,
+                                                              mode_t mode = Mask);
+
+    //! Number of mappings currently in the lookup() cache.
+    //! @version Added after 8.0.5
+    static size_t cacheSize();
+
 private:
     bool _compute(const PVStructure& base, const PVStructure& pvReq,
                   FieldBuilderPtr& builder, bool keepids, unsigned depth);
@@ -201,6 +250,7 @@ private:
               const BitSet& maskSrc,
               PVStructure& dest,
               BitSet& maskDest,
+              BitSet& scratch,
               bool dir_r2b) const;
     void _mapMask(const BitSet& maskSrc,
                   BitSet& maskDest,
@@ -216,15 +266,32 @@ private:
                frommask; // if !leaf these are the other bits in the source mask to be copied
         bool valid; // only true in (sparse) base -> requested mapping
         bool leaf; // not a (sub)Structure?
-        Mapping() :valid(false) {}
-        Mapping(size_t to, bool leaf) :to(to), valid(true), leaf(leaf) {}
+        size_t run; // if leaf, index in plan_t
+        Mapping() :valid(false), run(0) {}
+        Mapping(size_t to, bool leaf) :to(to), valid(true), leaf(leaf), run(0) {}
     };
     typedef std::vector<Mapping> mapping_t;
     mapping_t base2req, req2base;
 
-    std::string messages;
+    // Copy program compiled by compute().
+    // Leaf fields are grouped into runs of adjacent siblings, of the same type,
+    // which are also adjacent siblings in the destination.
+    typedef void (*copy_fn)(PVField& dest, const PVField& src);
+    struct CopyRun {
+        // indices of sub-fields leading from the top to the parent PVStructure
+        std::vector<size_t> srcPath, destPath;
+        size_t srcFirst; // offset of the first source field
+        size_t srcIndex, destIndex; // index of the first field in its parent
+        size_t count;
+        copy_fn copy;
+    };
+    typedef std::vector<CopyRun> plan_t;
+    plan_t planB2R, planR2B;
+
+    static void _compile(const PVStructure& src, const PVStructure& dest,
+                         mapping_t& map, plan_t& plan);
 
-    mutable BitSet scratch; // avoid temporary allocs.  (we aren't re-entrant!)
+    std::string messages;
 };
 
 }}
@@ -4,6 +4,8 @@
  */
 
 #include <sstream>
+#include <algorithm>
+#include <map>
 
 #include <epicsAssert.h>
 #include <epicsTypes.h>
@@ -12,6 +14,7 @@
 #include <epicsAssert.h>
 #include <epicsMutex.h>
 #include <epicsGuard.h>
+#include <epicsThread.h>
 
 #define epicsExportSharedSymbols
 #include <pv/createRequest.h>
@@ -21,8 +24,76 @@
 // Our arbitrary limit on pvRequest structure depth to bound stack usage during recursion
 static const unsigned maxDepth = 5;
 
+typedef epicsGuard<epicsMutex> Guard;
+
 namespace epics{namespace pvData {
 
+namespace {
+
+typedef void (*copier_t)(PVField& dest, const PVField& src);
+
+template<typename T>
+void copyScalar(PVField& dest, const PVField& src)
+{
+    if(dest.isImmutable())
+        throw std::invalid_argument("destination is immutable");
+    static_cast<PVScalarValue<T>&>(dest).put(static_cast<const PVScalarValue<T>&>(src).get());
+}
+
+void copyField(PVField& dest, const PVField& src)
+{
+    dest.copy(src);
+}
+
+// src and dest have the same Field, so scalars may be copied without conversion
+copier_t pickCopier(const Field& fld)
+{
+    if(fld.getType()!=scalar)
+        return &copyField;
+
+    switch(static_cast<const Scalar&>(fld).getScalarType()) {
+#define CASE(BASETYPE, PVATYPE, DBFTYPE, PVACODE) case pv ## PVACODE: return &copyScalar<PVATYPE>;
+#define CASE_REAL_INT64
+#define CASE_STRING
+#include "pv/typemap.h"
+#undef CASE_STRING
+#undef CASE_REAL_INT64
+#undef CASE
+    }
+    return &copyField;
+}
+
+size_t indexIn(const PVStructure& parent, const PVField *fld)
+{
+    const PVFieldPtrArray& flds = parent.getPVFields();
+    for(size_t i=0, N=flds.size(); i<N; i++) {
+        if(flds[i].get()==fld)
+            return i;
+    }
+    THROW_EXCEPTION2(std::logic_error, "Field not a member of its parent");
+}
+
+// path from the top level PVStructure to the parent of fld, and the index of fld in this parent
+void locate(const PVField& fld, std::vector<size_t>& path, size_t& index)
+{
+    const PVStructure *parent = fld.getParent();
+    index = indexIn(*parent, &fld);
+    path.clear();
+    for(const PVStructure *cur = parent; cur->getParent(); cur = cur->getParent())
+        path.push_back(indexIn(*cur->getParent(), cur));
+    std::reverse(path.begin(), path.end());
+}
+
+const PVFieldPtrArray& childrenOf(const PVStructure& top, const std::vector<size_t>& path)
+{
+    const PVStructure *cur = &top;
+    for(size_t i=0, N=path.size(); i<N; i++)
+        cur = static_cast<const PVStructure*>(cur->getPVFields()[path[i]].get());
+    return cur->getPVFields();
+}
+
+} // namespace
+
 PVRequestMapper::PVRequestMapper() {}
 
 PVRequestMapper::PVRequestMapper(const PVStructure &base,
@@ -135,6 +206,9 @@ void PVRequestMapper::compute(const PVStructure &base,
                 temp.base2req[parent->getFieldOffset()].frommask.set(b);
             }
         }
+
+        _compile(base, *proto, temp.base2req, temp.planB2R);
+        _compile(*proto, base, temp.req2base, temp.planR2B);
     }
 
     temp.maskRequested.set(0);
@@ -150,6 +224,51 @@ void PVRequestMapper::compute(const PVStructure &base,
     swap(temp);
 }
 
+void PVRequestMapper::_compile(const PVStructure& src, const PVStructure& dest,
+                               mapping_t& map, plan_t& plan)
+{
+    const PVField *prevSrc = 0, *prevDest = 0;
+
+    for(size_t i=1, N=map.size(); i<N; i++) {
+        Mapping& M = map[i];
+        if(!M.valid || !M.leaf)
+            continue;
+
+        PVField::const_shared_pointer fsrc(src.getSubFieldT(i)),
+                                      fdest(dest.getSubFieldT(M.to));
+        copier_t copy = pickCopier(*fsrc->getField());
+
+        if(!plan.empty()) {
+            CopyRun& R = plan.back();
+            // extend the current run when the previous source field is its last member,
+            // and is a sibling of this field in both source and destination.
+            if(R.srcFirst+R.count==i && R.copy==copy
+                    && map[i-1].to+1u==M.to
+                    && prevSrc->getParent()==fsrc->getParent()
+                    && prevDest->getParent()==fdest->getParent())
+            {
+                R.count++;
+                M.run = plan.size()-1u;
+                prevSrc = fsrc.get();
+                prevDest = fdest.get();
+                continue;
+            }
+        }
+
+        plan.push_back(CopyRun());
+        CopyRun& R = plan.back();
+        locate(*fsrc, R.srcPath, R.srcIndex);
+        locate(*fdest, R.destPath, R.destIndex);
+        R.srcFirst = i;
+        R.count = 1u;
+        R.copy = copy;
+
+        M.run = plan.size()-1u;
+        prevSrc = fsrc.get();
+        prevDest = fdest.get();
+    }
+}
+
 bool PVRequestMapper::_compute(const PVStructure& base, const PVStructure& pvReq,
                                FieldBuilderPtr& builder, bool keepids, unsigned depth)
 {
@@ -226,10 +345,21 @@ void PVRequestMapper::copyBaseToRequested(
         const BitSet& baseMask,
         PVStructure& request,
         BitSet& requestMask
+) const {
+    BitSet scratch;
+    copyBaseToRequested(base, baseMask, request, requestMask, scratch);
+}
+
+void PVRequestMapper::copyBaseToRequested(
+        const PVStructure& base,
+        const BitSet& baseMask,
+        PVStructure& request,
+        BitSet& requestMask,
+        BitSet& scratch
 ) const {
     assert(base.getStructure()==typeBase);
     assert(request.getStructure()==typeRequested);
-    _map(base, baseMask, request, requestMask, false);
+    _map(base, baseMask, request, requestMask, scratch, false);
 }
 
 void PVRequestMapper::copyBaseFromRequested(
@@ -237,19 +367,35 @@ void PVRequestMapper::copyBaseFromRequested(
         BitSet& baseMask,
         const PVStructure& request,
         const BitSet& requestMask
+) const {
+    BitSet scratch;
+    copyBaseFromRequested(base, baseMask, request, requestMask, scratch);
+}
+
+void PVRequestMapper::copyBaseFromRequested(
+        PVStructure& base,
+        BitSet& baseMask,
+        const PVStructure& request,
+        const BitSet& requestMask,
+        BitSet& scratch
 ) const {
     assert(base.getStructure()==typeBase);
     assert(request.getStructure()==typeRequested);
-    _map(request, requestMask, base, baseMask, true);
+    _map(request, requestMask, base, baseMask, scratch, true);
 }
 
 void PVRequestMapper::_map(const PVStructure& src, const BitSet& maskSrc,
                            PVStructure& dest, BitSet& maskDest,
+                           BitSet& scratch,
                            bool dir_r2b) const
 {
     {
         scratch = maskSrc;
         const mapping_t& map = dir_r2b ? req2base : base2req;
+        const plan_t& plan = dir_r2b ? planR2B : planB2R;
+        // parent fields of the current run
+        const CopyRun *run = 0;
+        const PVFieldPtrArray *fsrc = 0, *fdest = 0;
 
         assert(map.size()==src.getNumberFields());
 
@@ -259,9 +405,22 @@ void PVRequestMapper::_map(const PVStructure& src, const BitSet& maskSrc,
                 assert(!dir_r2b); // only base -> requested mapping can have holes
 
             } else if(M.leaf) {
-                // just copy
-                dest.getSubFieldT(M.to)->copy(*src.getSubFieldT(i));
-                maskDest.set(M.to);
+                const CopyRun& R = plan[M.run];
+                if(&R!=run) {
+                    run = &R;
+                    fsrc = &childrenOf(src, R.srcPath);
+                    fdest = &childrenOf(dest, R.destPath);
+                }
+
+                const size_t first = i - R.srcFirst;
+                size_t n = 1u;
+                if(first==0u && R.count>1u && scratch.allSet(i, i+R.count))
+                    n = R.count; // whole run selected
+
+                for(size_t k=first; k<first+n; k++)
+                    R.copy(*(*fdest)[R.destIndex+k], *(*fsrc)[R.srcIndex+k]);
+                maskDest.setRange(M.to, M.to+n);
+                i += int32(n-1u);
 
             } else {
                 // set bits of all sub-fields (in requested structure)
@@ -286,8 +445,8 @@ void PVRequestMapper::_mapMask(const BitSet& maskSrc,
     } else {
         const mapping_t& map = dir_r2b ? req2base : base2req;
 
-        for(int32 i=maskSrc.nextSetBit(0), N=map.size(); i>=0 && i<N; i=maskSrc.nextSetBit(i+1)) {
-            const Mapping& M = map[i];
+        for(BitSet::const_iterator it(maskSrc.begin()), end(maskSrc.end()); it!=end && *it<map.size(); ++it) {
+            const Mapping& M = map[*it];
             if(!M.valid) {
                 assert(!dir_r2b); // only base -> requested mapping can have holes
 
@@ -310,8 +469,9 @@ void PVRequestMapper::swap(PVRequestMapper& other)
     maskRequested.swap(other.maskRequested);
     base2req.swap(other.base2req);
     req2base.swap(other.req2base);
+    planB2R.swap(other.planB2R);
+    planR2B.swap(other.planR2B);
     messages.swap(other.messages);
-    scratch.swap(other.scratch); // paranoia
 }
 
 void PVRequestMapper::reset()
@@ -321,8 +481,123 @@ void PVRequestMapper::reset()
     maskRequested.clear();
     base2req.clear();
     req2base.clear();
+    planB2R.clear();
+    planR2B.clear();
     messages.clear();
-    scratch.clear(); // paranoia
+}
+
+namespace {
+
+struct MapperCache {
+    typedef std::pair<const Structure*, std::string> key_t;
+    typedef std::map<key_t, std::tr1::weak_ptr<const PVRequestMapper> > entries_t;
+
+    epicsMutex lock;
+    entries_t entries; // guarded by lock
+    size_t pruneAt; // guarded by lock
+
+    MapperCache() :pruneAt(16u) {}
+
+    // call with lock held
+    void prune() {
+        for(entries_t::iterator it(entries.begin()), end(entries.end()); it!=end;) {
+            entries_t::iterator cur(it++);
+            if(cur->second.expired())
+                entries.erase(cur);
+        }
+    }
+} *mapperCache;
+
+void mapperCacheInit(void *)
+{
+    mapperCache = new MapperCache;
+}
+
+epicsThreadOnceId mapperCacheOnce = EPICS_THREAD_ONCE_INIT;
+
+MapperCache& getMapperCache()
+{
+    epicsThreadOnce(&mapperCacheOnce, &mapperCacheInit, 0);
+    return *mapperCache;
+}
+
+// append the selection of a pvRequest 'field' sub-structure.  eg. "a{},b{c{},d{},},"
+void selectionKey(std::string& key, const Structure& sel)
+{
+    const StringArray& names = sel.getFieldNames();
+    const FieldConstPtrArray& fields = sel.getFields();
+    for(size_t i=0, N=names.size(); i<N; i++) {
+        key += names[i];
+        if(fields[i]->getType()==structure) {
+            key += '{';
+            selectionKey(key, static_cast<const Structure&>(*fields[i]));
+            key += '}';
+        } else {
+            key += '!'; // invalid, will be rejected by compute()
+        }
+        key += ',';
+    }
+}
+
+} // namespace
+
+std::tr1::shared_ptr<const PVRequestMapper>
+PVRequestMapper::lookup(const PVStructure& base,
+                        const PVStructure& pvRequest,
+                        mode_t mode)
+{
+    // Only those parts of pvRequest used by compute()
+    MapperCache::key_t key(base.getStructure().get(), std::string());
+    key.second += mode==Mask ? 'M' : 'S';
+    {
+        PVScalar::const_shared_pointer pbp(pvRequest.getSubField<PVScalar>("record._options.keepIDs"));
+        if(pbp) {
+            key.second += pbp->getAs<std::string>();
+        }
+        key.second += ':';
+    }
+    {
+        PVStructure::const_shared_pointer fields(pvRequest.getSubField<PVStructure>("field"));
+        if(fields)
+            selectionKey(key.second, *fields->getStructure());
+    }
+
+    MapperCache& cache = getMapperCache();
+    {
+        Guard G(cache.lock);
+        MapperCache::entries_t::iterator it(cache.entries.find(key));
+        if(it!=cache.entries.end()) {
+            std::tr1::shared_ptr<const PVRequestMapper> ret(it->second.lock());
+            if(ret)
+                return ret;
+        }
+    }
+
+    // compute outside of lock.  May throw.
+    std::tr1::shared_ptr<PVRequestMapper> mapper(new PVRequestMapper(base, pvRequest, mode));
+
+    Guard G(cache.lock);
+    // another thread may have raced with us
+    std::tr1::weak_ptr<const PVRequestMapper>& ent = cache.entries[key];
+    std::tr1::shared_ptr<const PVRequestMapper> ret(ent.lock());
+    if(!ret) {
+        ret = mapper;
+        ent = ret;
+
+        if(cache.entries.size()>=cache.pruneAt) {
+            cache.prune();
+            cache.pruneAt = std::max(size_t(16u), 2u*cache.entries.size());
+        }
+    }
+    return ret;
+}
+
+size_t PVRequestMapper::cacheSize()
+{
+    MapperCache& cache = getMapperCache();
+    Guard G(cache.lock);
+    cache.prune();
+    return cache.entries.size();
 }
 
 }} //namespace epics::pvData
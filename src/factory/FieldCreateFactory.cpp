@@ -11,6 +11,7 @@
 #include <cstdlib>
 #include <string>
 #include <cstdio>
+#include <cstring>
 #include <stdexcept>
 #include <sstream>
 
@@ -37,26 +38,81 @@ size_t Field::num_instances;
 
 
 struct Field::Helper {
+    static inline unsigned mix(unsigned H, unsigned V) {
+        return H ^ (V + 0x9e3779b9u + (H<<6) + (H>>2));
+    }
+
+    static unsigned hashMembers(unsigned H,
+                                const std::string& id,
+                                const StringArray& names,
+                                const FieldConstPtrArray& fields)
+    {
+        H = mix(H, epicsStrHash(id.c_str(), 0xbadc0de1));
+        for(size_t i=0, N=fields.size(); i<N; i++) {
+            H = mix(H, epicsStrHash(names[i].c_str(), 0xbadc0de1));
+            // members are already de-duplicated, so their hash is already computed
+            H = mix(H, fields[i]->m_hash);
+        }
+        return H;
+    }
+
+    // Structural hash computed bottom up from the hashes of (cached) members.
+    // Covers the same information as the operator<<() output
+    // which was previously hashed, without formatting it.
+    // stable only within this process.
     static unsigned hash(Field *fld) {
-        std::ostringstream key;
-        // hash the output of operator<<()
-        // not efficient, but stable within this process.
-        key<<(*fld);
-        unsigned H = epicsStrHash(key.str().c_str(), 0xbadc0de1);
+        unsigned H = mix(0xbadc0de1, fld->getType());
+        switch(fld->getType()) {
+        case scalar: {
+            const Scalar *S = static_cast<const Scalar*>(fld);
+            H = mix(H, S->getScalarType());
+            if(const BoundedString *B = dynamic_cast<const BoundedString*>(S))
+                H = mix(H, B->getMaximumLength());
+        }
+            break;
+        case scalarArray: {
+            const ScalarArray *A = static_cast<const ScalarArray*>(fld);
+            H = mix(H, A->getElementType());
+            H = mix(H, A->getArraySizeType());
+            H = mix(H, A->getMaximumCapacity());
+        }
+            break;
+        case structure: {
+            const Structure *S = static_cast<const Structure*>(fld);
+            H = hashMembers(H, S->getID(), S->getFieldNames(), S->getFields());
+        }
+            break;
+        case union_: {
+            const Union *U = static_cast<const Union*>(fld);
+            H = hashMembers(H, U->getID(), U->getFieldNames(), U->getFields());
+        }
+            break;
+        case structureArray:
+            H = mix(H, static_cast<const StructureArray*>(fld)->getStructure()->m_hash);
+            break;
+        case unionArray:
+            H = mix(H, static_cast<const UnionArray*>(fld)->getUnion()->m_hash);
+            break;
+        }
         fld->m_hash = H;
         return H;
     }
 };
 
 struct FieldCreate::Helper {
+    static inline CacheShard& shardFor(const FieldCreate *create, unsigned hash) {
+        return create->cacheShards[(hash ^ (hash>>16)) % numCacheShards];
+    }
+
     template<typename FLD>
     static void cache(const FieldCreate *create, std::tr1::shared_ptr<FLD>& ent) {
         unsigned hash = Field::Helper::hash(ent.get());
+        CacheShard& shard = shardFor(create, hash);
 
-        Lock G(create->mutex);
-        // we examine raw pointers stored in create->cache, which is safe under create->mutex
+        Lock G(shard.mutex);
+        // we examine raw pointers stored in shard.cache, which is safe under shard.mutex
 
-        std::pair<cache_t::iterator, cache_t::iterator> itp(create->cache.equal_range(hash));
+        std::pair<cache_t::iterator, cache_t::iterator> itp(shard.cache.equal_range(hash));
         for(; itp.first!=itp.second; ++itp.first) {
             Field* cent(itp.first->second);
             FLD* centx(dynamic_cast<FLD*>(cent));
@@ -73,7 +129,7 @@ struct FieldCreate::Helper {
             }
         }
 
-        create->cache.insert(std::make_pair(hash, ent.get()));
+        shard.cache.insert(std::make_pair(hash, ent.get()));
         // cache cleaned from Field::~Field
     }
 };
@@ -89,17 +145,25 @@ Field::~Field() {
     REFTRACE_DECREMENT(num_instances);
 }
 
+std::size_t Field::getSerializedSize() const
+{
+    // generic, by a serialization pass
+    return ::epics::pvData::getSerializedSize(static_cast<const Serializable*>(this));
+}
+
 void Field::cacheCleanup()
 {
     const FieldCreatePtr& create(getFieldCreate());
 
-    Lock G(create->mutex);
+    FieldCreate::CacheShard& shard = FieldCreate::Helper::shardFor(create.get(), m_hash);
 
-    std::pair<FieldCreate::cache_t::iterator, FieldCreate::cache_t::iterator> itp(create->cache.equal_range(m_hash));
+    Lock G(shard.mutex);
+
+    std::pair<FieldCreate::cache_t::iterator, FieldCreate::cache_t::iterator> itp(shard.cache.equal_range(m_hash));
     for(; itp.first!=itp.second; ++itp.first) {
         Field* cent(itp.first->second);
         if(cent==this) {
-            create->cache.erase(itp.first);
+            shard.cache.erase(itp.first);
             return;
         }
     }
@@ -177,6 +241,11 @@ void Scalar::serialize(ByteBuffer *buffer, SerializableControl *control) const {
     buffer->putByte(getTypeCodeLUT(scalarType));
 }
 
+std::size_t Scalar::getSerializedSize() const
+{
+    return 1u;
+}
+
 void Scalar::deserialize(ByteBuffer* /*buffer*/, DeserializableControl* /*control*/) {
     // must be done via FieldCreate
     throw std::runtime_error("not valid operation, use FieldCreate::deserialize instead");
@@ -204,6 +273,11 @@ void BoundedString::serialize(ByteBuffer *buffer, SerializableControl *control)
     SerializeHelper::writeSize(maxLength, buffer, control);
 }
 
+std::size_t BoundedString::getSerializedSize() const
+{
+    return 1u + SerializeHelper::sizeOfSize(maxLength);
+}
+
 std::size_t BoundedString::getMaximumLength() const
 {
     return maxLength;
@@ -222,6 +296,20 @@ BoundedString::~BoundedString()
 }
 
 
+// size written by serializeStructureField() or serializeUnionField()
+static std::size_t sizeOfFieldsField(const std::string& id, const std::string& defaultId,
+                                     StringArray const & fieldNames, FieldConstPtrArray const & fields)
+{
+    std::size_t ret = id==defaultId ? 1u : SerializeHelper::sizeOfString(id);
+    ret += SerializeHelper::sizeOfSize(fields.size());
+    for (std::size_t i = 0, N = fields.size(); i < N; i++)
+    {
+        ret += SerializeHelper::sizeOfString(fieldNames[i]);
+        ret += fields[i]->getSerializedSize();
+    }
+    return ret;
+}
+
 static void serializeStructureField(const Structure* structure, ByteBuffer* buffer, SerializableControl* control)
 {
     // to optimize default (non-empty) IDs optimization
@@ -354,6 +442,11 @@ void ScalarArray::serialize(ByteBuffer *buffer, SerializableControl *control) co
     buffer->putByte((int8)0x08 | Scalar::getTypeCodeLUT(elementType));
 }
 
+std::size_t ScalarArray::getSerializedSize() const
+{
+    return 1u;
+}
+
 void ScalarArray::deserialize(ByteBuffer* /*buffer*/, DeserializableControl* /*control*/) {
     throw std::runtime_error("not valid operation, use FieldCreate::deserialize instead");
 }
@@ -388,6 +481,11 @@ void BoundedScalarArray::serialize(ByteBuffer *buffer, SerializableControl *cont
     SerializeHelper::writeSize(size, buffer, control);
 }
 
+std::size_t BoundedScalarArray::getSerializedSize() const
+{
+    return 1u + SerializeHelper::sizeOfSize(size);
+}
+
 
 FixedScalarArray::~FixedScalarArray()
 {
@@ -413,6 +511,11 @@ void FixedScalarArray::serialize(ByteBuffer *buffer, SerializableControl *contro
     SerializeHelper::writeSize(size, buffer, control);
 }
 
+std::size_t FixedScalarArray::getSerializedSize() const
+{
+    return 1u + SerializeHelper::sizeOfSize(size);
+}
+
 
 
 StructureArray::StructureArray(StructureConstPtr const & structure)
@@ -446,6 +549,11 @@ void StructureArray::serialize(ByteBuffer *buffer, SerializableControl *control)
     control->cachedSerialize(pstructure, buffer);
 }
 
+std::size_t StructureArray::getSerializedSize() const
+{
+    return 1u + pstructure->getSerializedSize();
+}
+
 void StructureArray::deserialize(ByteBuffer* /*buffer*/, DeserializableControl* /*control*/) {
     throw std::runtime_error("not valid operation, use FieldCreate::deserialize instead");
 }
@@ -494,6 +602,11 @@ void UnionArray::serialize(ByteBuffer *buffer, SerializableControl *control) con
     }
 }
 
+std::size_t UnionArray::getSerializedSize() const
+{
+    return punion->isVariant() ? 1u : 1u + punion->getSerializedSize();
+}
+
 void UnionArray::deserialize(ByteBuffer* /*buffer*/, DeserializableControl* /*control*/) {
     throw std::runtime_error("not valid operation, use FieldCreate::deserialize instead");
 }
@@ -527,6 +640,14 @@ Structure::Structure (
         THROW_EXCEPTION2(std::invalid_argument, "Can't construct Structure, fieldNames.size()!=fields.size()");
     }
     size_t number = fields.size();
+
+    size_t nslots = 0;
+    if(number) {
+        // at least half empty to keep probe sequences short
+        for(nslots = 2; nslots < 2*number; nslots <<= 1) {}
+    }
+    nameIndex.resize(nslots, uint32(-1));
+
     for(size_t i=0; i<number; i++) {
         const string& name = fieldNames[i];
         if(name.empty()) {
@@ -534,17 +655,33 @@ Structure::Structure (
         }
         if(fields[i].get()==NULL)
             THROW_EXCEPTION2(std::invalid_argument, "Can't construct Structure, NULL in fields");
-        // look for duplicates
-        for(size_t j=i+1; j<number; j++) {
-            string otherName = fieldNames[j];
-            int result = name.compare(otherName);
-            if(result==0) {
+
+        size_t slot = epicsMemHash(name.c_str(), name.size(), 0) & (nslots-1);
+        for(; nameIndex[slot]!=uint32(-1); slot = (slot+1) & (nslots-1)) {
+            // look for duplicates
+            if(fieldNames[nameIndex[slot]]==name) {
                 string  message("Can't construct Structure, duplicate fieldName ");
                 message += name;
                 THROW_EXCEPTION2(std::invalid_argument, message);
             }
         }
+        nameIndex[slot] = uint32(i);
+    }
+
+    // field offset ranges of this and nested structures, as in PVField::computeOffset()
+    structureRanges.push_back(range_t(0u, 0u));
+    uint32 offset = 1u;
+    for(size_t i=0; i<number; i++) {
+        if(fields[i]->getType()==structure) {
+            const ranges_t& sub = static_cast<const Structure*>(fields[i].get())->structureRanges;
+            for(size_t j=0; j<sub.size(); j++)
+                structureRanges.push_back(range_t(offset+sub[j].first, offset+sub[j].second));
+            offset += sub[0].second;
+        } else {
+            offset++;
+        }
     }
+    structureRanges[0].second = offset;
 }
 
 Structure::~Structure()
@@ -559,28 +696,36 @@ string Structure::getID() const
 }
 
 FieldConstPtr  Structure::getField(string const & fieldName) const {
-    for(size_t i=0, N=fields.size(); i<N; i++) {
-        if(fieldName==fieldNames[i]) {
-            return fields[i];
-        }
-    }
+    size_t idx = getFieldIndex(fieldName.c_str(), fieldName.size());
+    if(idx!=size_t(-1))
+        return fields[idx];
     return FieldConstPtr();
 }
 
 size_t Structure::getFieldIndex(string const &fieldName) const {
-    size_t numberFields = fields.size();
-    for(size_t i=0; i<numberFields; i++) {
-        FieldConstPtr pfield = fields[i];
-        int result = fieldName.compare(fieldNames[i]);
-        if(result==0) return i;
+    return getFieldIndex(fieldName.c_str(), fieldName.size());
+}
+
+size_t Structure::getFieldIndex(const char *fieldName, size_t len) const {
+    const size_t nslots = nameIndex.size();
+    if(nslots==0)
+        return -1;
+
+    // table is never full, so this will find an empty slot if not a match
+    for(size_t slot = epicsMemHash(fieldName, len, 0) & (nslots-1); ; slot = (slot+1) & (nslots-1)) {
+        uint32 idx = nameIndex[slot];
+        if(idx==uint32(-1))
+            return -1;
+        const string& name = fieldNames[idx];
+        if(name.size()==len && memcmp(name.c_str(), fieldName, len)==0)
+            return idx;
     }
-    return -1;
 }
 
 FieldConstPtr Structure::getFieldImpl(string const & fieldName, bool throws) const {
-    for(size_t i=0, N=fields.size(); i<N; i++)
-        if(fieldName==fieldNames[i])
-            return fields[i];
+    size_t idx = getFieldIndex(fieldName.c_str(), fieldName.size());
+    if(idx!=size_t(-1))
+        return fields[idx];
 
     if (throws) {
         std::stringstream ss;
@@ -592,6 +737,63 @@ FieldConstPtr Structure::getFieldImpl(string const & fieldName, bool throws) con
     }
 }
 
+namespace {
+// number of fields, including this one, as counted by field offset
+size_t countFields(const Field& fld)
+{
+    size_t ret = 1;
+    if(fld.getType()==structure) {
+        const FieldConstPtrArray& fields = static_cast<const Structure&>(fld).getFields();
+        for(size_t i=0, N=fields.size(); i<N; i++)
+            ret += countFields(*fields[i]);
+    }
+    return ret;
+}
+}
+
+FieldPath::FieldPath(const StructureConstPtr& top, const std::string& path)
+    :type(top)
+    ,offset(0)
+{
+    if(!type)
+        THROW_EXCEPTION2(std::invalid_argument, "FieldPath requires a Structure");
+
+    const Structure *parent = type.get();
+    const char *name = path.c_str();
+
+    while(true) {
+        const char *sep = name;
+        while(*sep!='\0' && *sep!='.') sep++;
+
+        size_t idx = parent->getFieldIndex(name, sep-name);
+        if(idx==size_t(-1)) {
+            std::ostringstream ss;
+            ss << "Failed to get field: " << path << " ("
+               << std::string(path.c_str(), sep) << " not found)";
+            throw std::runtime_error(ss.str());
+        }
+
+        offset++;
+        for(size_t i=0; i<idx; i++)
+            offset += countFields(*parent->getField(i));
+
+        indices.push_back(uint32(idx));
+        field = parent->getField(idx);
+
+        if(*sep=='\0')
+            break;
+
+        if(field->getType()!=structure) {
+            std::ostringstream ss;
+            ss << "Failed to get field: " << path << " ("
+               << std::string(path.c_str(), sep) << " is not a structure)";
+            throw std::runtime_error(ss.str());
+        }
+        parent = static_cast<const Structure*>(field.get());
+        name = sep+1; // skip past '.'
+    }
+}
+
 std::ostream& Structure::dump(std::ostream& o) const
 {
     o << format::indent() << getID() << std::endl;
@@ -654,6 +856,11 @@ void Structure::serialize(ByteBuffer *buffer, SerializableControl *control) cons
     serializeStructureField(this, buffer, control);
 }
 
+std::size_t Structure::getSerializedSize() const
+{
+    return 1u + sizeOfFieldsField(id, DEFAULT_ID, fieldNames, fields);
+}
+
 void Structure::deserialize(ByteBuffer* /*buffer*/, DeserializableControl* /*control*/) {
     throw std::runtime_error("not valid operation, use FieldCreate::deserialize instead");
 }
@@ -875,6 +1082,13 @@ void Union::serialize(ByteBuffer *buffer, SerializableControl *control) const {
     }
 }
 
+std::size_t Union::getSerializedSize() const
+{
+    if (fields.size() == 0)
+        return 1u;
+    return 1u + sizeOfFieldsField(id, DEFAULT_ID, fieldNames, fields);
+}
+
 void Union::deserialize(ByteBuffer* /*buffer*/, DeserializableControl* /*control*/) {
     throw std::runtime_error("not valid operation, use FieldCreate::deserialize instead");
 }
@@ -11,9 +11,11 @@
 #include <cstdlib>
 #include <string>
 #include <cstdio>
+#include <new>
 
 #include <epicsMutex.h>
 #include <epicsThread.h>
+#include <epicsAtomic.h>
 
 #define epicsExportSharedSymbols
 #include <pv/lock.h>
@@ -22,12 +24,22 @@
 #include <pv/factory.h>
 #include <pv/serializeHelper.h>
 #include <pv/reftrack.h>
+#include <pv/pvStructurePool.h>
 
 using std::tr1::static_pointer_cast;
 using std::size_t;
 using std::string;
 using std::min;
 
+namespace {
+// shared_ptr deleter which keeps another object alive
+struct hold_ref {
+    std::tr1::shared_ptr<const void> ref;
+    explicit hold_ref(const std::tr1::shared_ptr<const void>& ref) :ref(ref) {}
+    void operator()(const void*) { ref.reset(); }
+};
+}
+
 namespace epics { namespace pvData {
 
 
@@ -116,6 +128,18 @@ void PVScalarValue<std::string>::serialize(ByteBuffer *pbuffer,
     SerializeHelper::serializeString(storage.value, pbuffer, pflusher);
 }
 
+template<typename T>
+std::size_t PVScalarValue<T>::getSerializedSize() const
+{
+    return sizeof(T);
+}
+
+template<>
+std::size_t PVScalarValue<std::string>::getSerializedSize() const
+{
+    return SerializeHelper::sizeOfString(storage.value);
+}
+
 template<typename T>
 void PVScalarValue<T>::deserialize(ByteBuffer *pbuffer,
     DeserializableControl *pflusher)
@@ -320,8 +344,34 @@ void PVValueArray<T>::deserialize(ByteBuffer *pbuffer,
                 this->getArray()->getMaximumCapacity() :
                 SerializeHelper::readSize(pbuffer, pcontrol);
 
-    svector nextvalue(thaw(value));
-    nextvalue.resize(size); // TODO: avoid copy of stuff we will then overwrite
+    if (size && !pbuffer->reverse<T>()) {
+        // try to reference values in place.
+        // Only if aligned, as the values will be accessed through T*
+        const char *raw = pbuffer->getBuffer() + pbuffer->getPosition();
+        std::tr1::shared_ptr<const void> owner;
+        if (((size_t)raw)%sizeof(T)==0u
+                && pcontrol->directDeserializeRef(pbuffer, size, sizeof(T), owner))
+        {
+            value = const_svector((const T*)raw, hold_ref(owner), 0, size);
+            borrowed = value;
+            pbuffer->setPosition(pbuffer->getPosition() + size*sizeof(T));
+            PVField::postPut();
+            return;
+        }
+    }
+
+    // Re-use existing storage only if we are the sole owner and it is large enough.
+    // Never true for borrowed storage.
+    // Previous values are not copied as they will be overwritten.
+    svector nextvalue;
+    if (value.unique() && value.capacity()>=size) {
+        nextvalue = thaw(value);
+        nextvalue.resize(size);
+    } else {
+        value.clear();
+        nextvalue = svector(size);
+    }
+    borrowed.clear();
 
     T* cur = nextvalue.data();
 
@@ -330,6 +380,7 @@ void PVValueArray<T>::deserialize(ByteBuffer *pbuffer,
     if (!pbuffer->reverse<T>())
         if (pcontrol->directDeserialize(pbuffer, (char*)cur, size, sizeof(T)))
         {
+        value = freeze(nextvalue);
         // inform about the change?
         PVField::postPut();
         return;
@@ -381,7 +432,7 @@ void PVValueArray<T>::serialize(ByteBuffer *pbuffer,
     // try to avoid copying into the buffer
     // this is only possible if we do not need to do endian-swapping
     if (!pbuffer->reverse<T>())
-        if (pflusher->directSerialize(pbuffer, (const char*)cur, count, sizeof(T)))
+        if (pflusher->directSerializeRef(pbuffer, (const char*)cur, count, sizeof(T), temp.dataPtr()))
             return;
 
     while(count) {
@@ -403,8 +454,31 @@ void PVValueArray<T>::serialize(ByteBuffer *pbuffer,
     }
 }
 
+template<typename T>
+std::size_t PVValueArray<T>::getSerializedSize() const
+{
+    std::size_t ret = value.size()*sizeof(T);
+    if (this->getArray()->getArraySizeType() != Array::fixed)
+        ret += SerializeHelper::sizeOfSize(value.size());
+    return ret;
+}
+
 // specializations for string
 
+template<>
+std::size_t PVValueArray<string>::getSerializedSize() const
+{
+    std::size_t ret = 0u;
+    if (this->getArray()->getArraySizeType() != Array::fixed)
+        ret += SerializeHelper::sizeOfSize(value.size());
+
+    const string * pvalue = value.data();
+    for(size_t i = 0, N = value.size(); i<N; i++) {
+        ret += SerializeHelper::sizeOfString(pvalue[i]);
+    }
+    return ret;
+}
+
 template<>
 void PVValueArray<string>::deserialize(ByteBuffer *pbuffer,
         DeserializableControl *pcontrol) {
@@ -706,6 +780,200 @@ PVStructurePtr PVDataCreate::createPVStructure(PVStructurePtr const & structToCl
     return pvStructure;
 }
 
+/* Flat storage.
+ *
+ * One block of memory holds the PVField instances of a PVStructure and of
+ * its scalar and structure members.  With c++11 it also holds their shared_ptr
+ * control blocks.  The block is reference counted, one reference for each
+ * allocation from it, and freed with the last.
+ */
+struct PVDataCreate::Arena {
+    enum {alignment = 16};
+
+    size_t refs;
+    char *next, *limit;
+
+    static size_t roundUp(size_t size) {
+        return (size + alignment-1u) & ~size_t(alignment-1u);
+    }
+
+    static Arena* create(size_t size) {
+        const size_t header = roundUp(sizeof(Arena));
+        char *raw = static_cast<char*>(::operator new(header + size));
+        Arena *self = new (raw) Arena;
+        self->refs = 1u; // released by createPVStructureFlat()
+        self->next = raw + header;
+        self->limit = self->next + size;
+        return self;
+    }
+
+    // only called while building, so no concurrent calls
+    void* allocate(size_t size) {
+        void *ret;
+        size = roundUp(size);
+        if(size_t(limit - next) >= size) {
+            ret = next;
+            next += size;
+        } else {
+            // estimate was short
+            ret = ::operator new(size);
+        }
+        epics::atomic::increment(refs);
+        return ret;
+    }
+
+    void deallocate(void *p) {
+        const char *c = static_cast<const char*>(p);
+        if(c < reinterpret_cast<const char*>(this) || c >= limit)
+            ::operator delete(p);
+        release();
+    }
+
+    void release() {
+        if(epics::atomic::decrement(refs)==0u) {
+            this->~Arena();
+            ::operator delete(static_cast<void*>(this));
+        }
+    }
+
+    struct Delete {
+        Arena *arena;
+        explicit Delete(Arena *arena) :arena(arena) {}
+        void operator()(PVField *fld) const {
+            void *mem = dynamic_cast<void*>(fld); // most derived
+            fld->~PVField();
+            arena->deallocate(mem);
+        }
+    };
+
+#if __cplusplus>=201103L
+    template<typename T>
+    struct Allocator {
+        typedef T value_type;
+        Arena *arena;
+        explicit Allocator(Arena *arena) :arena(arena) {}
+        template<typename U>
+        Allocator(const Allocator<U>& o) :arena(o.arena) {}
+        T* allocate(size_t n) { return static_cast<T*>(arena->allocate(n*sizeof(T))); }
+        void deallocate(T* p, size_t) { arena->deallocate(p); }
+        template<typename U>
+        bool operator==(const Allocator<U>& o) const { return arena==o.arena; }
+        template<typename U>
+        bool operator!=(const Allocator<U>& o) const { return arena!=o.arena; }
+    };
+    // guess at the size of a shared_ptr control block with Delete and Allocator
+    static size_t controlSize() { return roundUp(8u*sizeof(void*)); }
+#else
+    // tr1::shared_ptr can't use an allocator
+    static size_t controlSize() { return 0u; }
+#endif
+
+    static size_t estimate(const Field& field) {
+        switch(field.getType()) {
+        case scalar:
+            switch(static_cast<const Scalar&>(field).getScalarType()) {
+#define CASE(TYPE) case pv ## TYPE: return roundUp(sizeof(PV ## TYPE)) + controlSize()
+            CASE(Boolean);
+            CASE(Byte);
+            CASE(Short);
+            CASE(Int);
+            CASE(Long);
+            CASE(UByte);
+            CASE(UShort);
+            CASE(UInt);
+            CASE(ULong);
+            CASE(Float);
+            CASE(Double);
+            CASE(String);
+#undef CASE
+            }
+            return 0u;
+        case structure: {
+            size_t ret = roundUp(sizeof(PVStructure)) + controlSize();
+            const FieldConstPtrArray& fields = static_cast<const Structure&>(field).getFields();
+            for(size_t i=0, N=fields.size(); i<N; i++)
+                ret += estimate(*fields[i]);
+            return ret;
+        }
+        default:
+            return 0u; // not stored in arena
+        }
+    }
+};
+
+PVFieldPtr PVDataCreate::createPVFieldFlat(FieldConstPtr const & field, Arena& arena)
+{
+    void *mem;
+    PVField *raw;
+
+#define CONSTRUCT(TYPE, ARGS) \
+    mem = arena.allocate(sizeof(TYPE)); \
+    try { \
+        raw = new (mem) TYPE ARGS; \
+    } catch(...) { \
+        arena.deallocate(mem); \
+        throw; \
+    }
+
+    switch(field->getType()) {
+    case scalar: {
+        ScalarConstPtr S(static_pointer_cast<const Scalar>(field));
+        switch(S->getScalarType()) {
+#define CASE(TYPE) case pv ## TYPE: CONSTRUCT(PV ## TYPE, (S)); break
+        CASE(Boolean);
+        CASE(Byte);
+        CASE(Short);
+        CASE(Int);
+        CASE(Long);
+        CASE(UByte);
+        CASE(UShort);
+        CASE(UInt);
+        CASE(ULong);
+        CASE(Float);
+        CASE(Double);
+        CASE(String);
+#undef CASE
+        default:
+            throw std::logic_error("PVDataCreate::createPVFieldFlat should never get here");
+        }
+    }
+        break;
+    case structure: {
+        StructureConstPtr S(static_pointer_cast<const Structure>(field));
+        const FieldConstPtrArray& fields = S->getFields();
+        PVFieldPtrArray members(fields.size());
+        for(size_t i=0, N=fields.size(); i<N; i++)
+            members[i] = createPVFieldFlat(fields[i], arena);
+        CONSTRUCT(PVStructure, (S, members));
+    }
+        break;
+    default:
+        return createPVField(field);
+    }
+#undef CONSTRUCT
+
+    // on failure, shared_ptr ctor calls Delete
+#if __cplusplus>=201103L
+    return PVFieldPtr(raw, Arena::Delete(&arena), Arena::Allocator<void>(&arena));
+#else
+    return PVFieldPtr(raw, Arena::Delete(&arena));
+#endif
+}
+
+PVStructurePtr PVDataCreate::createPVStructureFlat(StructureConstPtr const & structure)
+{
+    Arena *arena = Arena::create(Arena::estimate(*structure));
+    try {
+        PVFieldPtr ret(createPVFieldFlat(structure, *arena));
+        // each member now holds a reference
+        arena->release();
+        return static_pointer_cast<PVStructure>(ret);
+    } catch(...) {
+        arena->release();
+        throw;
+    }
+}
+
 PVUnionPtr PVDataCreate::createPVUnion(PVUnionPtr const & unionToClone)
 {
     PVUnionPtr punion(new PVUnion(unionToClone->getUnion()));
@@ -719,6 +987,8 @@ struct pvfield_factory {
     PVDataCreatePtr pvDataCreate;
     pvfield_factory() :pvDataCreate(new PVDataCreate()) {
         registerRefCounter("PVField", &PVField::num_instances);
+        registerRefCounter("PVStructurePool", &PVStructurePool::num_instances);
+        registerRefCounter("PVStructurePool::free", &PVStructurePool::num_free);
     }
 };
 }
@@ -59,6 +59,11 @@ size_t PVField::getNumberFields() const
     return (nextFieldOffset - fieldOffset);
 }
 
+size_t PVField::getSerializedSize() const
+{
+    return ::epics::pvData::getSerializedSize(static_cast<const Serializable*>(this));
+}
+
 
 void PVField::setImmutable() {immutable = true;}
 
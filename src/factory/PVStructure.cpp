@@ -147,19 +147,11 @@ PVFieldPtr PVStructure::getSubFieldImpl(const char *name, bool throws) const
                 return PVFieldPtr();
         }
 
-        const PVFieldPtrArray& pvFields = parent->getPVFields();
-
         PVField *child = NULL;
 
-        for(size_t i=0, n=pvFields.size(); i!=n; i++) {
-            const PVFieldPtr& fld = pvFields[i];
-            const std::string& fname = fld->getFieldName();
-
-            if(fname.size()==N && memcmp(name, fname.c_str(), N)==0) {
-                child = fld.get();
-                break;
-            }
-        }
+        size_t idx = parent->getStructure()->getFieldIndex(name, N);
+        if(idx!=size_t(-1))
+            child = parent->pvFields[idx].get();
 
         if(!child)
         {
@@ -200,6 +192,17 @@ PVFieldPtr PVStructure::getSubFieldImpl(const char *name, bool throws) const
     }
 }
 
+PVFieldPtr PVStructure::getSubFieldImpl(const FieldPath& path, bool throws) const
+{
+    PVField *ret = getSubFieldRaw(path);
+    if(ret)
+        return ret->shared_from_this();
+    else if(throws)
+        throw std::runtime_error("Failed to get field: (FieldPath resolved against a different Structure)");
+    else
+        return PVFieldPtr();
+}
+
 void PVStructure::throwBadFieldType(const char *name)
 {
     std::ostringstream ss;
@@ -266,6 +269,48 @@ void PVStructure::serialize(ByteBuffer *pbuffer,
     }
 }
 
+size_t PVStructure::getSerializedSize() const
+{
+    size_t ret = 0u;
+    for(size_t i = 0, N = pvFields.size(); i<N; i++)
+        ret += pvFields[i]->getSerializedSize();
+    return ret;
+}
+
+size_t PVStructure::getSerializedSize(const BitSet& changed) const
+{
+    size_t numberFields = this->getNumberFields();
+    size_t offset = this->getFieldOffset();
+    int32 next = changed.nextSetBit(static_cast<uint32>(offset));
+
+    // no more changes or no changes in this structure
+    if(next<0||next>=static_cast<int32>(offset+numberFields)) return 0u;
+
+    // entire structure
+    if(static_cast<int32>(offset)==next)
+        return getSerializedSize();
+
+    size_t ret = 0u;
+    for(size_t i = 0, N = pvFields.size(); i<N; i++) {
+        const PVField* pvField = pvFields[i].get();
+        offset = pvField->getFieldOffset();
+        int32 inumberFields = static_cast<int32>(pvField->getNumberFields());
+        next = changed.nextSetBit(static_cast<uint32>(offset));
+
+        // no more changes
+        if(next<0) break;
+        //  no change in this pvField
+        if(next>=static_cast<int32>(offset+inumberFields)) continue;
+
+        if(inumberFields==1) {
+            ret += pvField->getSerializedSize();
+        } else {
+            ret += static_cast<const PVStructure*>(pvField)->getSerializedSize(changed);
+        }
+    }
+    return ret;
+}
+
 void PVStructure::deserialize(ByteBuffer *pbuffer,
         DeserializableControl *pcontrol, BitSet *pbitSet) {
     size_t offset = getFieldOffset();
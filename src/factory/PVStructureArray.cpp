@@ -212,6 +212,21 @@ void PVStructureArray::serialize(ByteBuffer *pbuffer,
     }
 }
 
+size_t PVStructureArray::getSerializedSize() const
+{
+    const_svector temp(view());
+
+    size_t ret = temp.size(); // one byte per element for NULL or not
+    if (this->getArray()->getArraySizeType() != Array::fixed)
+        ret += SerializeHelper::sizeOfSize(temp.size());
+
+    for(size_t i = 0, N = temp.size(); i<N; i++) {
+        if(temp[i].get())
+            ret += temp[i]->getSerializedSize();
+    }
+    return ret;
+}
+
 std::ostream& PVStructureArray::dumpValue(std::ostream& o) const
 {
     o << format::indent() << getStructureArray()->getID() << ' ' << getFieldName() << std::endl;
@@ -0,0 +1,163 @@
+/* PVStructurePool.cpp */
+/*
+ * Copyright information and license terms for this software can be
+ * found in the file LICENSE that is included with the distribution
+ */
+#include <vector>
+#include <stdexcept>
+
+#include <epicsAssert.h>
+#include <epicsMutex.h>
+#include <epicsGuard.h>
+
+#define epicsExportSharedSymbols
+#include <pv/reftrack.h>
+#include <pv/pvData.h>
+#include <pv/pvStructurePool.h>
+
+typedef epicsGuard<epicsMutex> Guard;
+typedef epicsGuardRelease<epicsMutex> UnGuard;
+
+namespace epics { namespace pvData {
+
+size_t PVStructurePool::num_instances;
+size_t PVStructurePool::num_free;
+
+struct PVStructurePool::Impl {
+    const StructureConstPtr type;
+    // default values used for reset.  NULL if reset not enabled.
+    const PVStructurePtr pristine;
+
+    mutable epicsMutex lock;
+    // guarded by lock
+    std::vector<PVStructure*> freelist;
+    size_t highWater;
+    bool closed;
+
+    Impl(const StructureConstPtr& type, size_t highWater, bool reset)
+        :type(type)
+        ,pristine(reset ? getPVDataCreate()->createPVStructure(type) : PVStructurePtr())
+        ,highWater(highWater)
+        ,closed(false)
+    {
+        freelist.reserve(highWater);
+    }
+
+    ~Impl() {
+        // the pool destructor has already emptied the freelist
+        assert(freelist.empty());
+    }
+
+    // called with lock held.  Unlocks to destroy excess instances
+    void trim(Guard& G, size_t limit) {
+        std::vector<PVStructure*> excess;
+        if(freelist.size() > limit) {
+            excess.assign(freelist.begin()+limit, freelist.end());
+            freelist.resize(limit);
+        }
+        if(!excess.empty()) {
+            UnGuard U(G);
+            for(size_t i=0, N=excess.size(); i<N; i++) {
+                REFTRACE_DECREMENT(num_free);
+                delete excess[i];
+            }
+        }
+    }
+
+    // shared_ptr deleter which returns instances to the freelist
+    struct Recycle {
+        std::tr1::shared_ptr<Impl> pool;
+        explicit Recycle(const std::tr1::shared_ptr<Impl>& pool) :pool(pool) {}
+        void operator()(PVStructure *inst) {
+            Impl& self = *pool;
+            if(!inst->isImmutable()) {
+                {
+                    Guard G(self.lock);
+                    if(self.closed || self.freelist.size() >= self.highWater) {
+                        UnGuard U(G);
+                        delete inst;
+                        return;
+                    }
+                }
+                // reset outside of lock
+                try {
+                    if(self.pristine)
+                        inst->copyUnchecked(*self.pristine);
+                } catch(...) {
+                    delete inst;
+                    return;
+                }
+
+                Guard G(self.lock);
+                if(!self.closed && self.freelist.size() < self.highWater) {
+                    self.freelist.push_back(inst);
+                    REFTRACE_INCREMENT(num_free);
+                    return;
+                }
+            }
+            delete inst;
+        }
+    };
+};
+
+PVStructurePool::PVStructurePool(StructureConstPtr const & type, size_t highWater, bool reset)
+{
+    if(!type)
+        throw std::invalid_argument("PVStructurePool requires a Structure");
+    impl.reset(new Impl(type, highWater, reset));
+    REFTRACE_INCREMENT(num_instances);
+}
+
+PVStructurePool::~PVStructurePool()
+{
+    {
+        Guard G(impl->lock);
+        impl->closed = true;
+        impl->trim(G, 0u);
+    }
+    REFTRACE_DECREMENT(num_instances);
+}
+
+PVStructurePtr PVStructurePool::get()
+{
+    PVStructure *inst = NULL;
+    {
+        Guard G(impl->lock);
+        if(!impl->freelist.empty()) {
+            inst = impl->freelist.back();
+            impl->freelist.pop_back();
+            REFTRACE_DECREMENT(num_free);
+        }
+    }
+    if(!inst)
+        inst = new PVStructure(impl->type);
+
+    // on failure, the shared_ptr ctor calls Recycle
+    return PVStructurePtr(inst, Impl::Recycle(impl));
+}
+
+const StructureConstPtr& PVStructurePool::getStructure() const
+{
+    return impl->type;
+}
+
+size_t PVStructurePool::freeCount() const
+{
+    Guard G(impl->lock);
+    return impl->freelist.size();
+}
+
+size_t PVStructurePool::getHighWater() const
+{
+    Guard G(impl->lock);
+    return impl->highWater;
+}
+
+void PVStructurePool::setHighWater(size_t highWater)
+{
+    Guard G(impl->lock);
+    impl->highWater = highWater;
+    impl->trim(G, highWater);
+}
+
+}} // namespace epics::pvData
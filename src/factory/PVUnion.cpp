@@ -141,6 +141,23 @@ void PVUnion::serialize(ByteBuffer *pbuffer, SerializableControl *pflusher) cons
     }
 }
 
+size_t PVUnion::getSerializedSize() const
+{
+    if (variant)
+    {
+        if (value.get() == 0)
+            return 1u;
+        return value->getField()->getSerializedSize() + value->getSerializedSize();
+    }
+    else
+    {
+        size_t ret = SerializeHelper::sizeOfSize(selector);
+        if (selector != UNDEFINED_INDEX)
+            ret += value->getSerializedSize();
+        return ret;
+    }
+}
+
 void PVUnion::deserialize(ByteBuffer *pbuffer, DeserializableControl *pcontrol)
 {
     if (variant)
@@ -211,6 +211,21 @@ void PVUnionArray::serialize(ByteBuffer *pbuffer,
     }
 }
 
+size_t PVUnionArray::getSerializedSize() const
+{
+    const_svector temp(view());
+
+    size_t ret = temp.size(); // one byte per element for NULL or not
+    if (this->getArray()->getArraySizeType() != Array::fixed)
+        ret += SerializeHelper::sizeOfSize(temp.size());
+
+    for(size_t i = 0, N = temp.size(); i<N; i++) {
+        if(temp[i].get())
+            ret += temp[i]->getSerializedSize();
+    }
+    return ret;
+}
+
 std::ostream& PVUnionArray::dumpValue(std::ostream& o) const
 {
     o << format::indent() << getUnionArray()->getID() << ' ' << getFieldName() << std::endl;
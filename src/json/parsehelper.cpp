@@ -5,6 +5,9 @@
 
 #include <stdexcept>
 #include <sstream>
+#include <algorithm>
+
+#include <string.h>
 
 #define epicsExportSharedSymbols
 #include <pv/pvdVersion.h>
@@ -13,106 +16,140 @@
 
 namespace {
 
-void check_trailing(const std::string& line)
+void check_trailing(const char *buf, size_t len)
 {
-    size_t idx = line.find_first_not_of(" \t\n\r");
-    if(idx==line.npos) return;
-    // TODO: detect the end of potentially multi-line comments...
-    // for now trailing comments not allowed
-    throw std::runtime_error("Trailing junk");
+    for(size_t i=0; i<len; i++) {
+        switch(buf[i]) {
+        case ' ':
+        case '\t':
+        case '\n':
+        case '\r':
+            continue;
+        }
+        // TODO: detect the end of potentially multi-line comments...
+        // for now trailing comments not allowed
+        throw std::runtime_error("Trailing junk");
+    }
 }
 
-} // namespace
+size_t count_lines(const char *buf, size_t len)
+{
+    return std::count(buf, buf+len, '\n');
+}
 
-namespace epics{namespace pvData{
+} // namespace
 
-bool yajl_parse_helper(std::istream& src,
-                       yajl_handle handle)
-{
-    unsigned linenum=0;
-#ifndef EPICS_YAJL_VERSION
-    bool done = false;
-#endif
+namespace epics{namespace pvData{namespace yajl{
 
-    std::string line;
-    while(std::getline(src, line)) {
-        linenum++;
+Feeder::Feeder(yajl_handle handle)
+    :handle(handle)
+    ,linenum(1u)
+    ,done(false)
+{}
 
-#ifndef EPICS_YAJL_VERSION
-        if(done) {
-            check_trailing(line);
-            continue;
-        }
-#endif
+bool Feeder::feed(const char *buf, size_t len)
+{
+    if(done) {
+        check_trailing(buf, len);
+        linenum += count_lines(buf, len);
+        return true;
+    }
 
-        yajl_status sts = yajl_parse(handle, (const unsigned char*)line.c_str(), line.size());
+    yajl_status sts = yajl_parse(handle, (const unsigned char*)buf, len);
 
-        switch(sts) {
-        case yajl_status_ok: {
-            size_t consumed = yajl_get_bytes_consumed(handle);
+    switch(sts) {
+    case yajl_status_ok: {
+        size_t consumed = yajl_get_bytes_consumed(handle);
 
-            if(consumed<line.size()) {
-                check_trailing(line.substr(consumed));
-            }
+        if(consumed<len) {
+            check_trailing(buf+consumed, len-consumed);
+        }
 
 #ifndef EPICS_YAJL_VERSION
-            done = true;
+        done = true;
 #endif
-            break;
-        }
-        case yajl_status_client_canceled:
-            return false;
+        break;
+    }
+    case yajl_status_client_canceled:
+        return false;
 #ifndef EPICS_YAJL_VERSION
-        case yajl_status_insufficient_data:
-            // continue with next line
-            break;
+    case yajl_status_insufficient_data:
+        // continue with next chunk
+        break;
 #endif
-        case yajl_status_error:
-        {
-            std::ostringstream msg;
-            unsigned char *raw = yajl_get_error(handle, 1, (const unsigned char*)line.c_str(), line.size());
-            if(!raw) {
-                msg<<"Unknown error on line "<<linenum;
-            } else {
-                try {
-                    msg<<"Error on line "<<linenum<<" : "<<(const char*)raw;
-                }catch(...){
-                    yajl_free_error(handle, raw);
-                    throw;
-                }
+    case yajl_status_error:
+    {
+        size_t consumed = std::min(len, size_t(yajl_get_bytes_consumed(handle)));
+        size_t errline = linenum + count_lines(buf, consumed);
+
+        std::ostringstream msg;
+        unsigned char *raw = yajl_get_error(handle, 1, (const unsigned char*)buf, len);
+        if(!raw) {
+            msg<<"Unknown error on line "<<errline;
+        } else {
+            try {
+                msg<<"Error on line "<<errline<<" : "<<(const char*)raw;
+            }catch(...){
                 yajl_free_error(handle, raw);
+                throw;
             }
-            throw std::runtime_error(msg.str());
-        }
+            yajl_free_error(handle, raw);
         }
+        throw std::runtime_error(msg.str());
+    }
     }
 
-    if(!src.eof() || src.bad()) {
-        std::ostringstream msg;
-        msg<<"I/O error after line "<<linenum;
-        throw std::runtime_error(msg.str());
+    linenum += count_lines(buf, len);
+    return true;
+}
+
+bool Feeder::complete()
+{
+    if(done)
+        return true;
+    done = true;
 
 #ifndef EPICS_YAJL_VERSION
-    } else if(!done) {
-        switch(yajl_parse_complete(handle)) {
+    switch(yajl_parse_complete(handle)) {
 #else
-    } else {
-        switch(yajl_complete_parse(handle)) {
+    switch(yajl_complete_parse(handle)) {
 #endif
-        case yajl_status_ok:
-            break;
-        case yajl_status_client_canceled:
-            return false;
+    case yajl_status_ok:
+        break;
+    case yajl_status_client_canceled:
+        return false;
 #ifndef EPICS_YAJL_VERSION
-        case yajl_status_insufficient_data:
-            throw std::runtime_error("unexpected end of input");
+    case yajl_status_insufficient_data:
+        throw std::runtime_error("unexpected end of input");
 #endif
-        case yajl_status_error:
-            throw std::runtime_error("Error while completing parsing");
-        }
+    case yajl_status_error:
+        throw std::runtime_error("Error while completing parsing");
     }
-
     return true;
 }
 
+} // namespace yajl
+
+bool yajl_parse_helper(std::istream& src,
+                       yajl_handle handle)
+{
+    yajl::Feeder feeder(handle);
+
+    char buf[1024];
+    while(src) {
+        src.read(buf, sizeof(buf));
+        size_t n = src.gcount();
+        if(n && !feeder.feed(buf, n))
+            return false;
+    }
+
+    if(!src.eof() || src.bad()) {
+        std::ostringstream msg;
+        msg<<"I/O error before line "<<feeder.line();
+        throw std::runtime_error(msg.str());
+    }
+
+    return feeder.complete();
+}
+
 }} // namespace epics::pvData
@@ -6,6 +6,21 @@
 #include <vector>
 #include <sstream>
 
+#include <stdio.h>
+#include <errno.h>
+#include <string.h>
+
+#if defined(__unix__) || defined(__APPLE__)
+#  include <unistd.h>
+#endif
+#if defined(_POSIX_MAPPED_FILES) && _POSIX_MAPPED_FILES>0
+#  define USE_MMAP
+#  include <sys/types.h>
+#  include <sys/stat.h>
+#  include <sys/mman.h>
+#  include <fcntl.h>
+#endif
+
 #define epicsExportSharedSymbols
 #include <pv/pvdVersion.h>
 #include <pv/pvData.h>
@@ -25,6 +40,8 @@ struct context {
     struct frame {
         pvd::PVFieldPtr fld;
         pvd::BitSet *assigned;
+        // scalar array elements accumulated until end_array
+        pvd::shared_vector<const void> arr;
         frame(const pvd::PVFieldPtr& fld, pvd::BitSet *assigned)
             :fld(fld), assigned(assigned)
         {}
@@ -69,18 +86,22 @@ void valueAssign(context *self, typename PVScalarT::value_type val)
     } else if(type==pvd::scalarArray) {
         pvd::PVScalarArray *fld(static_cast<pvd::PVScalarArray*>(back.fld.get()));
 
-        pvd::shared_vector<const void> carr;
-        fld->getAs(carr);
-
-        switch(carr.original_type())
+        // The first thaw() copies any existing elements, which are still referenced
+        // by the field (see jtree_start_array()).  back.arr is then uniquely referenced,
+        // so later thaw()s don't copy.
+        // Grow geometrically so that appending N elements is O(N)
+        switch(fld->getScalarArray()->getElementType())
         {
 #define CASE_STRING
 #define CASE_REAL_INT64
 #define CASE(BASETYPE, PVATYPE, DBFTYPE, PVACODE) case epics::pvData::pv##PVACODE: { \
-            pvd::shared_vector<const PVATYPE> arr(pvd::static_shared_vector_cast<const PVATYPE>(carr)); \
+            pvd::shared_vector<const PVATYPE> arr(pvd::static_shared_vector_cast<const PVATYPE>(back.arr)); \
+            back.arr.clear(); \
             pvd::shared_vector<PVATYPE> tarr(pvd::thaw(arr)); \
+            if(tarr.size()==tarr.capacity()) \
+                tarr.reserve(tarr.empty() ? 16u : 2u*tarr.size()); \
             tarr.push_back(pvd::castUnsafe<PVATYPE>(val)); \
-            carr = pvd::static_shared_vector_cast<const void>(pvd::freeze(tarr)); \
+            back.arr = pvd::static_shared_vector_cast<const void>(pvd::freeze(tarr)); \
             } break;
 #include <pv/typemap.h>
 #undef CASE
@@ -88,9 +109,7 @@ void valueAssign(context *self, typename PVScalarT::value_type val)
 #undef CASE_STRING
         }
 
-        fld->putFrom(carr);
-
-        // leave array field at top of stack
+        // leave array field at top of stack.  assigned in jtree_end_array()
 
     } else if(type==pvd::union_) {
         pvd::PVUnion* fld(static_cast<pvd::PVUnion*>(back.fld.get()));
@@ -238,6 +257,8 @@ int jtree_end_map(void * ctx)
 
             pvd::PVStructureArray::svector val(pvd::thaw(cval));
 
+            if(val.size()==val.capacity())
+                val.reserve(val.empty() ? 16u : 2u*val.size());
             val.push_back(std::tr1::static_pointer_cast<pvd::PVStructure>(elem.fld));
 
             sarr->replace(pvd::freeze(val));
@@ -253,8 +274,18 @@ int jtree_start_array(void * ctx)
         assert(!self->stack.empty());
         pvd::PVFieldPtr& back(self->stack.back().fld);
         pvd::Type type = back->getField()->getType();
-        if(type!=pvd::structureArray && type!=pvd::scalarArray)
+        if(type==pvd::scalarArray) {
+            pvd::PVScalarArray *fld(static_cast<pvd::PVScalarArray*>(back.get()));
+            context::frame& top(self->stack.back());
+
+            // elements are appended to any existing.
+            // The field is left unchanged until jtree_end_array(),
+            // so its value is kept if parsing fails.
+            fld->getAs(top.arr);
+
+        } else if(type!=pvd::structureArray) {
             throw std::runtime_error("Can't assign array");
+        }
 
         return 1;
     }CATCH()
@@ -263,9 +294,15 @@ int jtree_end_array(void * ctx)
 {
     TRY {
         assert(!self->stack.empty());
+        context::frame& back(self->stack.back());
 
-        if(self->stack.back().assigned)
-            self->stack.back().assigned->set(self->stack.back().fld->getFieldOffset());
+        if(back.fld->getField()->getType()==pvd::scalarArray) {
+            // commit accumulated elements
+            static_cast<pvd::PVScalarArray*>(back.fld.get())->putFrom(back.arr);
+        }
+
+        if(back.assigned)
+            back.assigned->set(back.fld->getFieldOffset());
         self->stack.pop_back();
         return 1;
     }CATCH()
@@ -303,44 +340,158 @@ struct noop {
     void operator()(pvd::PVField*) {}
 };
 
-} // namespace
-
-namespace epics{namespace pvData{
-
-epicsShareFunc
-void parseJSON(std::istream& strm,
-               PVField& dest,
-               BitSet *assigned)
+yajl_handle alloc_handle(context *ctxt)
 {
 #ifndef EPICS_YAJL_VERSION
     yajl_parser_config conf;
     memset(&conf, 0, sizeof(conf));
     conf.allowComments = 1;
     conf.checkUTF8 = 1;
+
+    return yajl_alloc(&jtree_cbs, &conf, NULL, ctxt);
+#else
+    yajl_handle handle = yajl_alloc(&jtree_cbs, NULL, ctxt);
+
+    if(handle)
+        yajl_config(handle, yajl_allow_comments, 1);
+    return handle;
 #endif
+}
 
+struct file {
+    FILE *fp;
+    explicit file(const char *fname) :fp(fopen(fname, "rb")) {
+        if(!fp) {
+            std::ostringstream msg;
+            msg<<"Unable to open \""<<fname<<"\" : "<<strerror(errno);
+            throw std::runtime_error(msg.str());
+        }
+    }
+    ~file() { fclose(fp); }
+};
+
+#ifdef USE_MMAP
+struct mapping {
+    void *base;
+    size_t len;
+    mapping(int fd, size_t len) :base(mmap(0, len, PROT_READ, MAP_PRIVATE, fd, 0)), len(len) {
+        if(base==MAP_FAILED)
+            throw std::runtime_error(std::string("Unable to mmap() : ")+strerror(errno));
+    }
+    ~mapping() { munmap(base, len); }
+};
+#endif
+
+} // namespace
+
+namespace epics{namespace pvData{
+
+struct JSONParser::Impl {
     // we won't create refs to 'dest' which presist beyond this call.
     // however, it is convienent to treat 'dest' in the same manner as
     // any union/structureArray memebers it may contain.
-    PVFieldPtr fakedest(&dest, noop());
+    PVFieldPtr fakedest;
+    context ctxt;
+    handler handle;
+    yajl::Feeder feeder;
+
+    Impl(PVField& dest, BitSet *assigned)
+        :fakedest(&dest, noop())
+        ,ctxt(fakedest, assigned)
+        ,handle(alloc_handle(&ctxt))
+        ,feeder(handle)
+    {}
+
+    void check(bool ok) {
+        if(!ok)
+            throw std::runtime_error(ctxt.msg);
+    }
 
-    context ctxt(fakedest, assigned);
+    void finish() {
+        if(!ctxt.stack.empty())
+            throw std::logic_error("field stack not empty");
+        assert(fakedest.use_count()==1);
+    }
+};
 
-#ifndef EPICS_YAJL_VERSION
-    handler handle(yajl_alloc(&jtree_cbs, &conf, NULL, &ctxt));
-#else
-    handler handle(yajl_alloc(&jtree_cbs, NULL, &ctxt));
+JSONParser::JSONParser(PVField& dest, BitSet *assigned)
+    :impl(new Impl(dest, assigned))
+{}
+
+JSONParser::~JSONParser()
+{
+    delete impl;
+}
 
-    yajl_config(handle, yajl_allow_comments, 1);
+void JSONParser::feed(const char *buf, size_t len)
+{
+    impl->check(impl->feeder.feed(buf, len));
+}
+
+void JSONParser::feedFile(const char *fname)
+{
+    file F(fname);
+
+#ifdef USE_MMAP
+    struct stat info;
+    if(fstat(fileno(F.fp), &info)==0 && S_ISREG(info.st_mode)) {
+        if(info.st_size==0)
+            return;
+        mapping M(fileno(F.fp), info.st_size);
+        // hint that input will be read once, front to back
+        (void)madvise(M.base, M.len, MADV_SEQUENTIAL);
+        feed((const char*)M.base, M.len);
+        return;
+    }
+    // not a regular file.  eg. a pipe.  fall back to read()
 #endif
 
+    char buf[4096];
+    size_t n;
+    while((n=fread(buf, 1, sizeof(buf), F.fp))>0u)
+        feed(buf, n);
+    if(ferror(F.fp)) {
+        std::ostringstream msg;
+        msg<<"I/O error reading \""<<fname<<"\" before line "<<impl->feeder.line();
+        throw std::runtime_error(msg.str());
+    }
+}
+
+void JSONParser::complete()
+{
+    impl->check(impl->feeder.complete());
+    impl->finish();
+}
 
-    if(!yajl_parse_helper(strm, handle))
-        throw std::runtime_error(ctxt.msg);
+epicsShareFunc
+void parseJSON(std::istream& strm,
+               PVField& dest,
+               BitSet *assigned)
+{
+    JSONParser::Impl P(dest, assigned);
+
+    P.check(yajl_parse_helper(strm, P.handle));
+    P.finish();
+}
 
-    if(!ctxt.stack.empty())
-        throw std::logic_error("field stack not empty");
-    assert(fakedest.use_count()==1);
+epicsShareFunc
+void parseJSON(const char *buf, size_t len,
+               PVField& dest,
+               BitSet *assigned)
+{
+    JSONParser P(dest, assigned);
+    P.feed(buf, len);
+    P.complete();
+}
+
+epicsShareFunc
+void parseJSONFile(const char *fname,
+                   PVField& dest,
+                   BitSet *assigned)
+{
+    JSONParser P(dest, assigned);
+    P.feedFile(fname);
+    P.complete();
 }
 
 }} // namespace epics::pvData
@@ -6,6 +6,8 @@
 #include <vector>
 #include <sstream>
 
+#include <string.h>
+
 #define epicsExportSharedSymbols
 #include <pv/pvdVersion.h>
 #include <pv/pvData.h>
@@ -18,23 +20,44 @@ namespace pvd = epics::pvData;
 namespace {
 
 struct args {
-    std::ostream& strm;
+    std::vector<char>& out;
     const pvd::JSONPrintOptions& opts;
 
     unsigned indent;
 
-    args(std::ostream& strm,
+    args(std::vector<char>& out,
          const pvd::JSONPrintOptions& opts)
-        :strm(strm)
+        :out(out)
         ,opts(opts)
         ,indent(opts.indent)
     {}
 
+    void put(char c) { out.push_back(c); }
+    void write(const char *s, size_t n) { out.insert(out.end(), s, s+n); }
+    void write(const char *s) { write(s, strlen(s)); }
+    void write(const std::string& s) { write(s.c_str(), s.size()); }
+
     void doIntent() {
         if(!opts.multiLine) return;
-        strm.put('\n');
-        unsigned i=indent;
-        while(i--) strm.put(' ');
+        out.push_back('\n');
+        out.insert(out.end(), indent, ' ');
+    }
+};
+
+// print without allocation, and with the fewest digits needed to round trip
+template<typename T>
+struct show_value {
+    static inline void op(args& A, T v) {
+        char buf[pvd::detail::printPODMaxLen];
+        char *end = pvd::detail::printPOD(buf, buf+sizeof(buf), v);
+        A.write(buf, end-buf);
+    }
+};
+template<> struct show_value<std::string> {
+    static inline void op(args& A, const std::string& v) {
+        A.put('\"');
+        A.write(v);
+        A.put('\"');
     }
 };
 
@@ -47,7 +70,7 @@ void show_struct(args& A, const pvd::PVStructure* fld, const pvd::BitSet *mask)
 
     const pvd::StringArray& names = type->getFieldNames();
 
-    A.strm.put('{');
+    A.put('{');
     A.indent++;
 
     bool first = true;
@@ -58,15 +81,17 @@ void show_struct(args& A, const pvd::PVStructure* fld, const pvd::BitSet *mask)
         if(first)
             first = false;
         else
-            A.strm.put(',');
+            A.put(',');
         A.doIntent();
-        A.strm<<'\"'<<names[i]<<"\": ";
+        A.put('\"');
+        A.write(names[i]);
+        A.write("\": ", 3);
         show_field(A, children[i].get(), mask);
     }
 
     A.indent--;
     A.doIntent();
-    A.strm.put('}');
+    A.put('}');
 }
 
 void show_field(args& A, const pvd::PVField* fld, const pvd::BitSet *mask)
@@ -76,34 +101,45 @@ void show_field(args& A, const pvd::PVField* fld, const pvd::BitSet *mask)
     case pvd::scalar:
     {
         const pvd::PVScalar *scalar=static_cast<const pvd::PVScalar*>(fld);
-        if(scalar->getScalar()->getScalarType()==pvd::pvString) {
-            A.strm<<'\"'<<scalar->getAs<std::string>()<<'\"';
-        } else {
-            A.strm<<scalar->getAs<std::string>();
+        switch(scalar->getScalar()->getScalarType())
+        {
+#define CASE_REAL_INT64
+#define CASE_STRING
+#define CASE(BASETYPE, PVATYPE, DBFTYPE, PVACODE) case pvd::pv##PVACODE: \
+            show_value<PVATYPE>::op(A, static_cast<const pvd::PV##PVACODE*>(scalar)->get()); break;
+#include <pv/typemap.h>
+#undef CASE
+#undef CASE_STRING
+#undef CASE_REAL_INT64
         }
     }
         return;
     case pvd::scalarArray:
     {
         const pvd::PVScalarArray *scalar=static_cast<const pvd::PVScalarArray*>(fld);
-        const bool isstring = scalar->getScalarArray()->getElementType()==pvd::pvString;
 
         pvd::shared_vector<const void> arr;
         scalar->getAs<void>(arr);
 
-        pvd::shared_vector<const std::string> sarr(pvd::shared_vector_convert<const std::string>(arr));
-
-        A.strm.put('[');
-        for(size_t i=0, N=sarr.size(); i<N; i++) {
-            if(i!=0)
-                A.strm.put(',');
-            if(isstring)
-                A.strm.put('\"');
-            A.strm<<sarr[i];
-            if(isstring)
-                A.strm.put('\"');
+        A.put('[');
+        switch(arr.original_type())
+        {
+#define CASE_REAL_INT64
+#define CASE_STRING
+#define CASE(BASETYPE, PVATYPE, DBFTYPE, PVACODE) case pvd::pv##PVACODE: { \
+            pvd::shared_vector<const PVATYPE> tarr(pvd::static_shared_vector_cast<const PVATYPE>(arr)); \
+            for(size_t i=0, N=tarr.size(); i<N; i++) { \
+                if(i!=0) \
+                    A.put(','); \
+                show_value<PVATYPE>::op(A, tarr[i]); \
+            } \
+        } break;
+#include <pv/typemap.h>
+#undef CASE
+#undef CASE_STRING
+#undef CASE_REAL_INT64
         }
-        A.strm.put(']');
+        A.put(']');
     }
         return;
     case pvd::structure:
@@ -112,22 +148,22 @@ void show_field(args& A, const pvd::PVField* fld, const pvd::BitSet *mask)
     case pvd::structureArray:
     {
         pvd::PVStructureArray::const_svector arr(static_cast<const pvd::PVStructureArray*>(fld)->view());
-        A.strm.put('[');
+        A.put('[');
         A.indent++;
 
         for(size_t i=0, N=arr.size(); i<N; i++) {
             if(i!=0)
-                A.strm.put(',');
+                A.put(',');
             A.doIntent();
             if(arr[i])
                 show_struct(A, arr[i].get(), 0);
             else
-                A.strm<<"NULL";
+                A.write("NULL", 4);
         }
 
         A.indent--;
         A.doIntent();
-        A.strm.put(']');
+        A.put(']');
     }
         return;
     case pvd::union_:
@@ -136,7 +172,7 @@ void show_field(args& A, const pvd::PVField* fld, const pvd::BitSet *mask)
         const pvd::PVField::const_shared_pointer& C(U->get());
 
         if(!C) {
-            A.strm<<"null";
+            A.write("null", 4);
         } else {
             show_field(A, C.get(), 0);
         }
@@ -145,29 +181,29 @@ void show_field(args& A, const pvd::PVField* fld, const pvd::BitSet *mask)
     case pvd::unionArray: {
         const pvd::PVUnionArray *U=static_cast<const pvd::PVUnionArray*>(fld);
         pvd::PVUnionArray::const_svector arr(U->view());
-        A.strm.put('[');
+        A.put('[');
         A.indent++;
 
         for(size_t i=0, N=arr.size(); i<N; i++) {
             if(i!=0)
-                A.strm.put(',');
+                A.put(',');
             A.doIntent();
             if(arr[i])
                 show_field(A, arr[i].get(), 0);
             else
-                A.strm<<"NULL";
+                A.write("NULL", 4);
         }
 
         A.indent--;
         A.doIntent();
-        A.strm.put(']');
+        A.put(']');
 
     }
         return;
     }
     // should not be reached
     if(A.opts.ignoreUnprintable)
-        A.strm<<"// unprintable field type";
+        A.write("// unprintable field type");
     else
         throw std::runtime_error("Encountered unprintable field type");
 }
@@ -208,24 +244,45 @@ JSONPrintOptions::JSONPrintOptions()
     ,indent(0)
 {}
 
-void printJSON(std::ostream& strm,
+void printJSON(std::vector<char>& buf,
                const PVStructure& val,
                const BitSet& mask,
                const JSONPrintOptions& opts)
 {
-    args A(strm, opts);
+    args A(buf, opts);
     pvd::BitSet emask(mask);
     expandBS(val, emask, true);
     if(!emask.get(0)) return;
     show_struct(A, &val, &emask);
 }
 
-void printJSON(std::ostream& strm,
+void printJSON(std::vector<char>& buf,
                const PVField& val,
                const JSONPrintOptions& opts)
 {
-    args A(strm, opts);
+    args A(buf, opts);
     show_field(A, &val, 0);
 }
 
+void printJSON(std::ostream& strm,
+               const PVStructure& val,
+               const BitSet& mask,
+               const JSONPrintOptions& opts)
+{
+    std::vector<char> buf;
+    printJSON(buf, val, mask, opts);
+    if(!buf.empty())
+        strm.write(&buf[0], buf.size());
+}
+
+void printJSON(std::ostream& strm,
+               const PVField& val,
+               const JSONPrintOptions& opts)
+{
+    std::vector<char> buf;
+    printJSON(buf, val, opts);
+    if(!buf.empty())
+        strm.write(&buf[0], buf.size());
+}
+
 }} // namespace epics::pvData
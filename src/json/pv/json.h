@@ -8,6 +8,7 @@
 #include <istream>
 #include <ostream>
 #include <string>
+#include <vector>
 #include <map>
 
 #include <pv/pvdVersion.h>
@@ -66,6 +67,36 @@ void printJSON(std::ostream& strm,
                const PVField& val,
                const JSONPrintOptions& opts = JSONPrintOptions());
 
+/** Print PVStructure as JSON, appending to a buffer
+ *
+ * 'mask' selects those fields which will be printed.
+ * Prefer this form when printing repeatedly, as a buffer may be re-used
+ * (cleared) to avoid allocation.
+ *
+ * @code
+ *   std::vector<char> buf;
+ *   ...
+ *   buf.clear();
+ *   printJSON(buf, *value, changed);
+ *   send(sock, &buf[0], buf.size(), 0);
+ * @endcode
+ *
+ * @version Added after 8.0.5
+ */
+epicsShareFunc
+void printJSON(std::vector<char>& buf,
+               const PVStructure& val,
+               const BitSet& mask,
+               const JSONPrintOptions& opts = JSONPrintOptions());
+
+/** Print PVField as JSON, appending to a buffer
+ * @version Added after 8.0.5
+ */
+epicsShareFunc
+void printJSON(std::vector<char>& buf,
+               const PVField& val,
+               const JSONPrintOptions& opts = JSONPrintOptions());
+
 // To be deprecated in favor of previous form
 FORCE_INLINE
 void printJSON(std::ostream& strm,
@@ -113,6 +144,75 @@ void parseJSON(std::istream& strm,
     parseJSON(strm, *dest, assigned);
 }
 
+/** Parse JSON text from a buffer and store into the provided PVStructure.
+ *
+ * As parseJSON(std::istream&, PVField&, BitSet*)
+ *
+ * @version Added after 8.0.5
+ */
+epicsShareFunc
+void parseJSON(const char *buf, size_t len,
+               PVField& dest,
+               BitSet *assigned=0);
+
+/** Parse JSON text from a file and store into the provided PVStructure.
+ *
+ * As parseJSON(std::istream&, PVField&, BitSet*).
+ * Where supported, the file is mapped into memory and parsed in place.
+ *
+ * @param fname File name
+ * @version Added after 8.0.5
+ */
+epicsShareFunc
+void parseJSONFile(const char *fname,
+                   PVField& dest,
+                   BitSet *assigned=0);
+
+/** Incremental parsing of JSON into the provided PVStructure.
+ *
+ * For input which arrives in pieces, eg. from a network socket.
+ * Input may be split at any point, including within a token.
+ * Restrictions are as for parseJSON(std::istream&, PVField&, BitSet*)
+ *
+ * @code
+ *   JSONParser parser(*dest, &changed);
+ *   while(...)
+ *       parser.feed(chunk, chunklen);
+ *   parser.complete();
+ * @endcode
+ *
+ * @version Added after 8.0.5
+ */
+class epicsShareClass JSONParser
+{
+    EPICS_NOT_COPYABLE(JSONParser)
+public:
+    /**
+     * @param dest Store in fields of this structure.  Must out-live the JSONParser.
+     * @param assigned Which fields of _dest_ were assigned. (Optional)
+     */
+    explicit JSONParser(PVField& dest, BitSet *assigned=0);
+    ~JSONParser();
+
+    /** Parse more input
+     * @throws std::runtime_error on failure.  dest and assigned may be modified.
+     */
+    void feed(const char *buf, size_t len);
+    /** Parse the entire contents of a file as more input.
+     * Where supported, the file is mapped into memory.
+     * @throws std::runtime_error on failure.  dest and assigned may be modified.
+     */
+    void feedFile(const char *fname);
+    /** Signal end of input and finish parsing.
+     * @throws std::runtime_error if input is incomplete.
+     */
+    void complete();
+
+    struct Impl;
+private:
+    Impl *impl;
+};
+
 
 /** Wrapper around yajl_parse()
  *
@@ -139,6 +239,33 @@ typedef unsigned size_arg;
 typedef long long integer_arg;
 typedef size_t size_arg;
 #endif
+
+/** Push input to a yajl parser in arbitrary chunks.
+ *
+ * Wraps yajl_parse() and yajl_complete_parse().
+ * Errors if extranious non-whitespace found after the point were parsing completes.
+ *
+ * @version Added after 8.0.5
+ */
+class epicsShareClass Feeder
+{
+    yajl_handle handle;
+    size_t linenum;
+    bool done;
+public:
+    //! @param handle A parser handle previously allocated with yajl_alloc().  Not free'd.
+    explicit Feeder(yajl_handle handle);
+    /** Parse more input.
+     * @returns false if parsing cancelled by callback.  throws other errors
+     */
+    bool feed(const char *buf, size_t len);
+    /** Signal end of input
+     * @returns true if parsing completes successfully.  false if parsing cancelled by callback.  throws other errors
+     */
+    bool complete();
+    //! Current input line number, counting from 1
+    inline size_t line() const { return linenum; }
+};
 } // namespace epics::pvData::yajl
 
 /** @} */
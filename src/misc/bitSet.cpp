@@ -36,11 +36,84 @@
 #define WORD_INDEX(bitn) ((bitn)>>ADDRESS_BITS_PER_WORD)
 // bit offset within word
 #define WORD_OFFSET(bitn) ((bitn)&BIT_INDEX_MASK)
+// mask of bits at and above bitn within its word
+#define LOW_MASK(bitn) (WORD_MASK << WORD_OFFSET(bitn))
+// mask of bits at and below bitn within its word
+#define HIGH_MASK(bitn) (WORD_MASK >> (BIT_INDEX_MASK - WORD_OFFSET(bitn)))
 
 // the words vector should be size()d as small as posible,
 // so the last word should always have a bit set when the set is not empty
 #define CHECK_POST() assert(words.empty() || words.back()!=0)
 
+#if defined(__SSE2__)
+#  include <emmintrin.h>
+#endif
+
+/* x86 POPCNT is not part of the x86_64 baseline, so select at runtime.
+ */
+#if (defined(__x86_64__) || defined(__i386__)) && \
+    (defined(__clang__) || (defined(__GNUC__) && (__GNUC__>4 || (__GNUC__==4 && __GNUC_MINOR__>=9))))
+#  define USE_X86_POPCNT
+#endif
+
+namespace {
+using epics::pvData::uint32;
+using epics::pvData::uint64;
+
+// word-wise operations, combining src into dest
+struct op_and {
+    static uint64 apply(uint64 a, uint64 b) { return a&b; }
+#if defined(__SSE2__)
+    static __m128i apply(__m128i a, __m128i b) { return _mm_and_si128(a, b); }
+#endif
+};
+struct op_or {
+    static uint64 apply(uint64 a, uint64 b) { return a|b; }
+#if defined(__SSE2__)
+    static __m128i apply(__m128i a, __m128i b) { return _mm_or_si128(a, b); }
+#endif
+};
+struct op_xor {
+    static uint64 apply(uint64 a, uint64 b) { return a^b; }
+#if defined(__SSE2__)
+    static __m128i apply(__m128i a, __m128i b) { return _mm_xor_si128(a, b); }
+#endif
+};
+
+template<typename OP>
+void combine(uint64 *dest, const uint64 *src, size_t n)
+{
+    size_t i = 0;
+#if defined(__SSE2__)
+    for(; i+2u<=n; i+=2u) {
+        __m128i A = _mm_loadu_si128((const __m128i*)(dest+i)),
+                B = _mm_loadu_si128((const __m128i*)(src+i));
+        _mm_storeu_si128((__m128i*)(dest+i), OP::apply(A, B));
+    }
+#endif
+    for(; i<n; i++)
+        dest[i] = OP::apply(dest[i], src[i]);
+}
+
+#ifdef USE_X86_POPCNT
+__attribute__((target("popcnt")))
+uint32 popcount_hw(const uint64 *words, size_t n)
+{
+    uint32 sum = 0;
+    for(size_t i=0; i<n; i++)
+        sum += __builtin_popcountll(words[i]);
+    return sum;
+}
+
+bool have_popcnt()
+{
+    static const bool have = (__builtin_cpu_init(), __builtin_cpu_supports("popcnt"));
+    return have;
+}
+#endif
+
+} // namespace
+
 namespace epics { namespace pvData {
 
     BitSet::shared_pointer BitSet::create(uint32 nbits)
@@ -137,10 +210,78 @@ namespace epics { namespace pvData {
         words.clear();
     }
 
+    BitSet& BitSet::setRange(uint32 fromIndex, uint32 toIndex) {
+        if (fromIndex >= toIndex)
+            return *this;
+
+        uint32 first = WORD_INDEX(fromIndex),
+               last = WORD_INDEX(toIndex-1u);
+        expandTo(last);
+
+        if (first == last) {
+            words[first] |= LOW_MASK(fromIndex) & HIGH_MASK(toIndex-1u);
+        } else {
+            words[first] |= LOW_MASK(fromIndex);
+            for (uint32 i = first+1u; i < last; i++)
+                words[i] = WORD_MASK;
+            words[last] |= HIGH_MASK(toIndex-1u);
+        }
+        return *this;
+    }
+
+    BitSet& BitSet::clearRange(uint32 fromIndex, uint32 toIndex) {
+        if (fromIndex >= toIndex || WORD_INDEX(fromIndex) >= words.size())
+            return *this;
+
+        uint32 first = WORD_INDEX(fromIndex),
+               last = WORD_INDEX(toIndex-1u);
+        uint64 lastMask = HIGH_MASK(toIndex-1u);
+        if (last >= words.size()) {
+            last = words.size()-1u;
+            lastMask = WORD_MASK;
+        }
+
+        if (first == last) {
+            words[first] &= ~(LOW_MASK(fromIndex) & lastMask);
+        } else {
+            words[first] &= ~LOW_MASK(fromIndex);
+            for (uint32 i = first+1u; i < last; i++)
+                words[i] = 0u;
+            words[last] &= ~lastMask;
+        }
+
+        recalculateWordsInUse();
+        return *this;
+    }
+
+    bool BitSet::allSet(uint32 fromIndex, uint32 toIndex) const {
+        if (fromIndex >= toIndex)
+            return true;
+
+        uint32 first = WORD_INDEX(fromIndex),
+               last = WORD_INDEX(toIndex-1u);
+        if (last >= words.size())
+            return false;
+
+        if (first == last) {
+            uint64 mask = LOW_MASK(fromIndex) & HIGH_MASK(toIndex-1u);
+            return (words[first] & mask) == mask;
+        }
+        if ((words[first] & LOW_MASK(fromIndex)) != LOW_MASK(fromIndex))
+            return false;
+        for (uint32 i = first+1u; i < last; i++)
+            if (words[i] != WORD_MASK)
+                return false;
+        return (words[last] & HIGH_MASK(toIndex-1u)) == HIGH_MASK(toIndex-1u);
+    }
+
     uint32 BitSet::numberOfTrailingZeros(uint64 i) {
+        if (i == 0) return 64;
+#if defined(__GNUC__) || (defined(_MSC_VER) && defined(_M_X64))
+        return lowestSetBit(i);
+#else
         // HD, Figure 5-14
         uint32 x, y;
-        if (i == 0) return 64;
         uint32 n = 63;
         y = (uint32)i; if (y != 0) { n = n -32; x = y; } else x = (uint32)(i>>32);
         y = x <<16; if (y != 0) { n = n -16; x = y; }
@@ -148,9 +289,13 @@ namespace epics { namespace pvData {
         y = x << 4; if (y != 0) { n = n - 4; x = y; }
         y = x << 2; if (y != 0) { n = n - 2; x = y; }
         return n - ((x << 1) >> 31);
+#endif
     }
 
     uint32 BitSet::bitCount(uint64 i) {
+#if defined(__GNUC__)
+        return __builtin_popcountll(i);
+#else
         // HD, Figure 5-14
         i = i - ((i >> 1) & 0x5555555555555555LL);
         i = (i & 0x3333333333333333LL) + ((i >> 2) & 0x3333333333333333LL);
@@ -159,7 +304,8 @@ namespace epics { namespace pvData {
         i = i + (i >> 16);
         i = i + (i >> 32);
         return (uint32)(i & 0x7f);
-     }
+#endif
+    }
 
     int32 BitSet::nextSetBit(uint32 fromIndex) const {
 
@@ -171,7 +317,7 @@ namespace epics { namespace pvData {
 
         while (true) {
             if (word != 0)
-                return (u * BITS_PER_WORD) + numberOfTrailingZeros(word);
+                return (u * BITS_PER_WORD) + lowestSetBit(word);
             if (++u == words.size())
                 return -1;
             word = words[u];
@@ -189,7 +335,7 @@ namespace epics { namespace pvData {
 
         while (true) {
             if (word != 0)
-                return (u * BITS_PER_WORD) + numberOfTrailingZeros(word);
+                return (u * BITS_PER_WORD) + lowestSetBit(word);
             if (++u == words.size())
                 return words.size() * BITS_PER_WORD;
             word = ~words[u];
@@ -201,6 +347,10 @@ namespace epics { namespace pvData {
     }
 
     uint32 BitSet::cardinality() const {
+#ifdef USE_X86_POPCNT
+        if (!words.empty() && have_popcnt())
+            return popcount_hw(words.data(), words.size());
+#endif
         uint32 sum = 0;
         for (uint32 i = 0; i < words.size(); i++)
             sum += bitCount(words[i]);
@@ -232,8 +382,8 @@ namespace epics { namespace pvData {
         // the result length will be <= the shorter of the two inputs
         words.resize(std::min(words.size(), set.words.size()), 0);
 
-        for(size_t i=0, e=words.size(); i<e; i++)
-            words[i] &= set.words[i];
+        if(!words.empty())
+            combine<op_and>(words.data(), set.words.data(), words.size());
 
         recalculateWordsInUse();
         return *this;
@@ -247,8 +397,8 @@ namespace epics { namespace pvData {
         words.resize(std::max(words.size(), set.words.size()), 0);
 
         // since we expand w/ zeros, then iterate using the size of the other vector
-        for(size_t i=0, e=set.words.size(); i<e; i++)
-            words[i] |= set.words[i];
+        if(!set.words.empty())
+            combine<op_or>(words.data(), set.words.data(), set.words.size());
 
         CHECK_POST();
         return *this;
@@ -258,8 +408,8 @@ namespace epics { namespace pvData {
         // result length will <= the longer of the two inputs
         words.resize(std::max(words.size(), set.words.size()), 0);
 
-        for(size_t i=0, e=set.words.size(); i<e; i++)
-            words[i] ^= set.words[i];
+        if(!set.words.empty())
+            combine<op_xor>(words.data(), set.words.data(), set.words.size());
 
         recalculateWordsInUse();
         return *this;
@@ -299,12 +449,7 @@ namespace epics { namespace pvData {
         if (words.size() != set.words.size())
             return false;
 
-        // Check words in use by both BitSets
-        for (uint32 i = 0; i < words.size(); i++)
-            if (words[i] != set.words[i])
-                return false;
-
-        return true;
+        return words.empty() || memcmp(words.data(), set.words.data(), words.size()*BYTES_PER_WORD)==0;
     }
 
     bool BitSet::operator!=(const BitSet &set) const
@@ -8,3 +8,119 @@
 
 #define epicsExportSharedSymbols
 #include <pv/byteBuffer.h>
+
+/* x86 SSSE3 and AVX2 provide byte shuffles which swap a vector of
+ * elements at once.  Selected at runtime, so that the library
+ * remains usable on older CPUs.
+ */
+#if (defined(__x86_64__) || defined(__i386__)) && \
+    (defined(__clang__) || (defined(__GNUC__) && (__GNUC__>4 || (__GNUC__==4 && __GNUC_MINOR__>=9))))
+#  define USE_X86_SIMD
+#  include <immintrin.h>
+#endif
+
+namespace epics { namespace pvData { namespace detail {
+
+namespace {
+
+#ifdef USE_X86_SIMD
+
+// for each size of element, shuffle pattern to reverse the bytes of each element in a 16 byte lane
+const char swap_masks[3][16] = {
+    {1,0, 3,2, 5,4, 7,6, 9,8, 11,10, 13,12, 15,14},
+    {3,2,1,0, 7,6,5,4, 11,10,9,8, 15,14,13,12},
+    {7,6,5,4,3,2,1,0, 15,14,13,12,11,10,9,8},
+};
+
+struct cpu_features {
+    bool ssse3, avx2;
+    cpu_features() {
+        __builtin_cpu_init();
+        ssse3 = __builtin_cpu_supports("ssse3");
+        avx2 = __builtin_cpu_supports("avx2");
+    }
+};
+
+const cpu_features& features()
+{
+    static cpu_features F;
+    return F;
+}
+
+// returns the number of bytes processed, a multiple of 16
+__attribute__((target("ssse3")))
+size_t swap_ssse3(char *dest, const char *src, size_t nbytes, const char *mask)
+{
+    const __m128i M = _mm_loadu_si128((const __m128i*)mask);
+    size_t i = 0;
+    for(; i+16u<=nbytes; i+=16u) {
+        __m128i V = _mm_loadu_si128((const __m128i*)(src+i));
+        _mm_storeu_si128((__m128i*)(dest+i), _mm_shuffle_epi8(V, M));
+    }
+    return i;
+}
+
+// returns the number of bytes processed, a multiple of 16
+__attribute__((target("avx2")))
+size_t swap_avx2(char *dest, const char *src, size_t nbytes, const char *mask)
+{
+    const __m128i M1 = _mm_loadu_si128((const __m128i*)mask);
+    // _mm256_shuffle_epi8() shuffles within each 16 byte lane
+    const __m256i M = _mm256_broadcastsi128_si256(M1);
+    size_t i = 0;
+    for(; i+64u<=nbytes; i+=64u) {
+        __m256i A = _mm256_loadu_si256((const __m256i*)(src+i)),
+                B = _mm256_loadu_si256((const __m256i*)(src+i+32u));
+        _mm256_storeu_si256((__m256i*)(dest+i), _mm256_shuffle_epi8(A, M));
+        _mm256_storeu_si256((__m256i*)(dest+i+32u), _mm256_shuffle_epi8(B, M));
+    }
+    for(; i+16u<=nbytes; i+=16u) {
+        __m128i V = _mm_loadu_si128((const __m128i*)(src+i));
+        _mm_storeu_si128((__m128i*)(dest+i), _mm_shuffle_epi8(V, M1));
+    }
+    return i;
+}
+
+#endif // USE_X86_SIMD
+
+template<typename T>
+void swap_copyT(char *dest, const char *src, size_t count)
+{
+    const size_t nbytes = count*sizeof(T);
+    size_t i = 0;
+
+#ifdef USE_X86_SIMD
+    const char *mask = swap_masks[sizeof(T)==2 ? 0 : sizeof(T)==4 ? 1 : 2];
+
+    if(nbytes>=16u) {
+        const cpu_features& F = features();
+        if(F.avx2)
+            i = swap_avx2(dest, src, nbytes, mask);
+        else if(F.ssse3)
+            i = swap_ssse3(dest, src, nbytes, mask);
+    }
+#endif
+
+    for(; i<nbytes; i+=sizeof(T)) {
+        store_unaligned(dest+i, ::epics::pvData::swap<T>(load_unaligned<T>(src+i)));
+    }
+}
+
+} // namespace
+
+void swap_copy2(char *dest, const char *src, std::size_t count)
+{
+    swap_copyT<uint16>(dest, src, count);
+}
+
+void swap_copy4(char *dest, const char *src, std::size_t count)
+{
+    swap_copyT<uint32>(dest, src, count);
+}
+
+void swap_copy8(char *dest, const char *src, std::size_t count)
+{
+    swap_copyT<uint64>(dest, src, count);
+}
+
+}}} // namespace epics::pvData::detail
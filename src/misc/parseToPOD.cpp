@@ -2,16 +2,24 @@
  * Copyright information and license terms for this software can be
  * found in the file LICENSE that is included with the distribution
  */
+#include <limits>
+
+#if __cplusplus>=201703L
+#  include <charconv>
+#endif
+
 #include <ctype.h>
 #include <stdio.h>
 #include <errno.h>
 #include <float.h>
 #include <limits.h>
+#include <string.h>
 
 #include <epicsVersion.h>
 
 #include <epicsMath.h>
 #include <epicsStdlib.h>
+#include <epicsStdio.h>
 #include <epicsString.h>
 #include <epicsConvert.h>
 
@@ -19,92 +27,340 @@
 #include "pv/typeCast.h"
 
 using std::string;
+using epics::pvData::uint64;
 
-// need to use "long long" when sizeof(int)==sizeof(long)
-#if (ULONG_MAX == 0xfffffffful) || defined(_WIN32) || defined(__rtems__) || defined(__APPLE__)
-#define NEED_LONGLONG
+// double arithmetic is not done with extended precision
+#if defined(FLT_EVAL_METHOD)
+#  define EXACT_DOUBLE (FLT_EVAL_METHOD==0)
+#elif defined(__FLT_EVAL_METHOD__)
+#  define EXACT_DOUBLE (__FLT_EVAL_METHOD__==0)
+#else
+#  define EXACT_DOUBLE 0
 #endif
 
-/* do we need long long? */
-#ifdef NEED_LONGLONG
-static int
-epicsParseLongLong(const char *str, long long *to, int base, char **units)
+static
+void handleParseError(int err)
+{
+    switch(err) {
+    case 0: break;
+    case S_stdlib_noConversion: throw std::runtime_error("parseToPOD: No digits to convert");
+    case S_stdlib_extraneous: throw std::runtime_error("parseToPOD: Extraneous characters");
+    case S_stdlib_underflow: throw std::runtime_error("parseToPOD: Too small to represent");
+    case S_stdlib_overflow: throw std::runtime_error("parseToPOD: Too large to represent");
+    case S_stdlib_badBase: throw std::runtime_error("parseToPOD: Number base not supported");
+    default:
+        throw std::runtime_error("parseToPOD: unknown error");
+    }
+}
+
+namespace {
+
+// isspace() in the "C" locale
+inline bool isBlank(char c)
+{
+    return c==' ' || (c>='\t' && c<='\r');
+}
+
+inline const char* skipBlank(const char *in)
 {
-    int c;
-    char *endp;
-    long long value;
+    while(isBlank(*in))
+        in++;
+    return in;
+}
+
+/* Parse an integer as strtoull(in, &end, 0) would, but without regard
+ * to locale or errno.  The sign is returned separately from the magnitude.
+ * Leading and trailing blanks are ignored.
+ */
+int parseInteger(const char *in, uint64 *mag, bool *neg)
+{
+    in = skipBlank(in);
+
+    *neg = *in=='-';
+    if(*in=='-' || *in=='+')
+        in++;
+
+    unsigned base = 10u;
+    if(in[0]=='0') {
+        char h = in[2];
+        if((in[1]=='x' || in[1]=='X') && ((h>='0' && h<='9') || (h>='a' && h<='f') || (h>='A' && h<='F'))) {
+            base = 16u;
+            in += 2;
+        } else {
+            base = 8u;
+        }
+    }
 
-    while ((c = *str) && isspace(c))
-        ++str;
+    const char *start = in;
+    uint64 val = 0u;
+    bool over = false;
 
-    errno = 0;
-    value = strtoll(str, &endp, base);
+    for(;; in++) {
+        unsigned digit;
+        char c = *in;
+        if(c>='0' && c<='9')
+            digit = c-'0';
+        else if(c>='a' && c<='f')
+            digit = c-'a'+10;
+        else if(c>='A' && c<='F')
+            digit = c-'A'+10;
+        else
+            break;
+        if(digit>=base)
+            break;
 
-    if (endp == str)
+        // like strtoull(), consume all digits even after overflow
+        if(val > (std::numeric_limits<uint64>::max()-digit)/base)
+            over = true;
+        val = val*base + digit;
+    }
+
+    if(in==start)
         return S_stdlib_noConversion;
-    if (errno == EINVAL)    /* Not universally supported */
-        return S_stdlib_badBase;
-    if (errno == ERANGE)
+    else if(over)
         return S_stdlib_overflow;
-
-    while ((c = *endp) && isspace(c))
-        ++endp;
-    if (c && !units)
+    else if(*skipBlank(in))
         return S_stdlib_extraneous;
 
-    *to = value;
-    if (units)
-        *units = endp;
+    *mag = val;
     return 0;
 }
 
-static int
-epicsParseULongLong(const char *str, unsigned long long *to, int base, char **units)
+/* Range checks are those of epicsParseInt8() and friends.
+ * Unsigned types accept a negative value, which wraps as with strtoul().
+ */
+template<typename T>
+void parseIntegerT(const char *in, T *out)
 {
-    int c;
-    char *endp;
-    unsigned long long value;
+    uint64 mag;
+    bool neg;
+    int err = parseInteger(in, &mag, &neg);
+    if(err)
+        handleParseError(err);
 
-    while ((c = *str) && isspace(c))
-        ++str;
+    const uint64 max = uint64(std::numeric_limits<T>::max());
 
-    errno = 0;
-    value = strtoull(str, &endp, base);
+    if(!std::numeric_limits<T>::is_signed) {
+        if(mag > max)
+            handleParseError(S_stdlib_overflow);
+        *out = neg ? T(T(0)-T(mag)) : T(mag);
 
-    if (endp == str)
-        return S_stdlib_noConversion;
-    if (errno == EINVAL)    /* Not universally supported */
-        return S_stdlib_badBase;
-    if (errno == ERANGE)
-        return S_stdlib_overflow;
+    } else if(!neg) {
+        if(mag > max)
+            handleParseError(S_stdlib_overflow);
+        *out = T(mag);
 
-    while ((c = *endp) && isspace(c))
-        ++endp;
-    if (c && !units)
-        return S_stdlib_extraneous;
+    } else {
+        // negate w/o overflow, including for the most negative value
+        if(mag > max+1u)
+            handleParseError(S_stdlib_overflow);
+        *out = mag ? T(-T(mag-1u)-1) : T(0);
+    }
+}
 
-    *to = value;
-    if (units)
-        *units = endp;
-    return 0;
+/* The common case of a decimal number with few enough significant digits
+ * to fit exactly in the mantissa of a double, and an exponent small
+ * enough that its power of 10 is also exact.  The result of a single
+ * multiply or divide is then correctly rounded.
+ * (Clinger, "How to Read Floating Point Numbers Accurately", 1990)
+ *
+ * Returns false to defer anything else to the general case.
+ */
+bool parseFastDouble(const char *in, double *out)
+{
+#if EXACT_DOUBLE
+    static const double pow10[] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+    };
+    static const uint64 maxExact = uint64(1u)<<53;
+
+    in = skipBlank(in);
+
+    bool neg = *in=='-';
+    if(*in=='-' || *in=='+')
+        in++;
+
+    uint64 mant = 0u;
+    unsigned ndigits = 0u, nsig = 0u;
+    int exp10 = 0;
+
+    for(; *in>='0' && *in<='9'; in++, ndigits++) {
+        if(nsig || *in!='0') {
+            mant = mant*10u + unsigned(*in-'0');
+            nsig++;
+        }
+        if(nsig>19u)
+            return false;
+    }
+    if(*in=='.') {
+        for(in++; *in>='0' && *in<='9'; in++, ndigits++) {
+            if(nsig || *in!='0') {
+                mant = mant*10u + unsigned(*in-'0');
+                nsig++;
+            }
+            exp10--;
+            if(nsig>19u)
+                return false;
+        }
+    }
+    if(!ndigits)
+        return false; // maybe "inf" or "nan"
+
+    if(*in=='e' || *in=='E') {
+        in++;
+        bool eneg = *in=='-';
+        if(*in=='-' || *in=='+')
+            in++;
+        if(*in<'0' || *in>'9')
+            return false;
+        int e = 0;
+        for(; *in>='0' && *in<='9'; in++) {
+            e = e*10 + (*in-'0');
+            if(e>9999)
+                return false;
+        }
+        exp10 += eneg ? -e : e;
+    }
+
+    if(*skipBlank(in) || mant>maxExact || exp10 < -22 || exp10 > 22)
+        return false;
+
+    double val = double(mant);
+    if(exp10<0)
+        val /= pow10[-exp10];
+    else
+        val *= pow10[exp10];
+
+    *out = neg ? -val : val;
+    return true;
+#else
+    // extended precision intermediates (eg. x87) would round twice
+    return false;
+#endif
 }
+
+// Parse as double w/o regard to locale when possible.
+// Returns false to defer to epicsParseDouble()
+bool parseDecimalDouble(const char *in, double *out)
+{
+    if(parseFastDouble(in, out))
+        return true;
+
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars>=201611L
+    in = skipBlank(in);
+
+    // std::from_chars() doesn't accept a leading '+'
+    bool neg = *in=='-';
+    if(*in=='-' || *in=='+')
+        in++;
+    if(*in=='-' || *in=='+')
+        return false;
+
+    const char *end = in + strlen(in);
+    double val;
+    std::from_chars_result ret(std::from_chars(in, end, val));
+
+    // leave out of range, and sub-normal, to strtod() which may report ERANGE
+    if(ret.ec==std::errc() && !*skipBlank(ret.ptr) && (val==0.0 || (fabs(val)>=DBL_MIN && fabs(val)<=DBL_MAX))) {
+        *out = neg ? -val : val;
+        return true;
+    }
 #endif
+    return false;
+}
 
-static
-void handleParseError(int err)
+/* Print unsigned in base 10, two digits at a time.
+ * Works backwards from the end of buf, which must have room for 20 digits.
+ * Returns pointer to the first digit.
+ */
+char* printDigits(char *end, uint64 val)
 {
-    switch(err) {
-    case 0: break;
-    case S_stdlib_noConversion: throw std::runtime_error("parseToPOD: No digits to convert");
-    case S_stdlib_extraneous: throw std::runtime_error("parseToPOD: Extraneous characters");
-    case S_stdlib_underflow: throw std::runtime_error("parseToPOD: Too small to represent");
-    case S_stdlib_overflow: throw std::runtime_error("parseToPOD: Too large to represent");
-    case S_stdlib_badBase: throw std::runtime_error("parseToPOD: Number base not supported");
-    default:
-        throw std::runtime_error("parseToPOD: unknown error");
+    static const char pairs[] =
+        "00010203040506070809"
+        "10111213141516171819"
+        "20212223242526272829"
+        "30313233343536373839"
+        "40414243444546474849"
+        "50515253545556575859"
+        "60616263646566676869"
+        "70717273747576777879"
+        "80818283848586878889"
+        "90919293949596979899";
+    char *pos = end;
+    while(val>=100u) {
+        unsigned i = unsigned(val%100u)*2u;
+        val /= 100u;
+        *--pos = pairs[i+1];
+        *--pos = pairs[i];
+    }
+    if(val>=10u) {
+        unsigned i = unsigned(val)*2u;
+        *--pos = pairs[i+1];
+        *--pos = pairs[i];
+    } else {
+        *--pos = char('0'+val);
     }
+    return pos;
 }
 
+char* printInteger(char *first, char *last, uint64 val, bool neg)
+{
+    char buf[24];
+    char *end = buf+sizeof(buf),
+         *pos = printDigits(end, val);
+    if(neg)
+        *--pos = '-';
+    size_t len = end-pos;
+    if(size_t(last-first) < len)
+        return NULL;
+    memcpy(first, pos, len);
+    return first+len;
+}
+
+template<typename T>
+char* printSigned(char *first, char *last, T val)
+{
+    // negate as unsigned to handle the most negative value
+    if(val<0)
+        return printInteger(first, last, ~uint64(epics::pvData::int64(val))+1u, true);
+    else
+        return printInteger(first, last, uint64(val), false);
+}
+
+// Print with the fewest significant digits which parse back to the same value.
+template<typename T>
+char* printReal(char *first, char *last, T val, int minprec, int maxprec)
+{
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars>=201611L
+    std::to_chars_result ret(std::to_chars(first, last, val));
+    return ret.ec==std::errc() ? ret.ptr : NULL;
+#else
+    char buf[epics::pvData::detail::printPODMaxLen];
+    // %g discards trailing zeros, so the first precision which round trips is the shortest.
+    int len = 0;
+    for(int prec=minprec; prec<=maxprec; prec++) {
+        len = epicsSnprintf(buf, sizeof(buf), "%.*g", prec, double(val));
+        double back;
+        if(!parseFastDouble(buf, &back))
+            back = epicsStrtod(buf, 0);
+        if(prec==maxprec || T(back)==val || val!=val)
+            break;
+    }
+    if(len<0 || size_t(len)>=sizeof(buf) || last-first < len)
+        return NULL;
+    // undo a locale which uses some other decimal point
+    for(int i=0; i<len; i++) {
+        if(buf[i]==',')
+            buf[i] = '.';
+    }
+    memcpy(first, buf, len);
+    return first+len;
+#endif
+}
+
+} // namespace
+
 namespace epics { namespace pvData { namespace detail {
 
 void parseToPOD(const char* in, boolean *out)
@@ -117,45 +373,29 @@ void parseToPOD(const char* in, boolean *out)
         throw std::runtime_error("parseToPOD: string no match true/false");
 }
 
-#define INTFN(T, S) \
-void parseToPOD(const char* in, T *out) { \
-    epics ## S temp; \
-    int err = epicsParse ## S (in, &temp, 0, NULL); \
-    if(err)   handleParseError(err); \
-    else      *out = temp; \
-}
-
-INTFN(int8, Int8);
-INTFN(uint8, UInt8);
-INTFN(int16_t, Int16);
-INTFN(uint16_t, UInt16);
-INTFN(int32_t, Int32);
-INTFN(uint32_t, UInt32);
-
-void parseToPOD(const char* in, int64_t *out) {
-#ifdef NEED_LONGLONG
-    int err = epicsParseLongLong(in, out, 0, NULL);
-#else
-    int err = epicsParseLong(in, out, 0, NULL);
-#endif
-    if(err)   handleParseError(err);
-}
-
-void parseToPOD(const char* in, uint64_t *out) {
-#ifdef NEED_LONGLONG
-    int err = epicsParseULongLong(in, out, 0, NULL);
-#else
-    int err = epicsParseULong(in, out, 0, NULL);
-#endif
-    if(err)   handleParseError(err);
-}
+void parseToPOD(const char* in, int8 *out) { parseIntegerT(in, out); }
+void parseToPOD(const char* in, uint8 *out) { parseIntegerT(in, out); }
+void parseToPOD(const char* in, int16_t *out) { parseIntegerT(in, out); }
+void parseToPOD(const char* in, uint16_t *out) { parseIntegerT(in, out); }
+void parseToPOD(const char* in, int32_t *out) { parseIntegerT(in, out); }
+void parseToPOD(const char* in, uint32_t *out) { parseIntegerT(in, out); }
+void parseToPOD(const char* in, int64_t *out) { parseIntegerT(in, out); }
+void parseToPOD(const char* in, uint64_t *out) { parseIntegerT(in, out); }
 
 void parseToPOD(const char* in, float *out) {
+    double val;
+    // only values well within range.  Leave the edges to epicsParseFloat()
+    if(parseDecimalDouble(in, &val) && (val==0.0 || (fabs(val)>FLT_MIN && fabs(val)<FLT_MAX))) {
+        *out = float(val);
+        return;
+    }
     int err = epicsParseFloat(in, out, NULL);
     if(err)   handleParseError(err);
 }
 
 void parseToPOD(const char* in, double *out) {
+    if(parseDecimalDouble(in, out))
+        return;
     int err = epicsParseDouble(in, out, NULL);
     if(err)   handleParseError(err);
 #if defined(vxWorks)
@@ -181,4 +421,33 @@ void parseToPOD(const char* in, double *out) {
 #endif
 }
 
+char* printPOD(char *first, char *last, boolean val)
+{
+    const char *s = val ? "true" : "false";
+    size_t len = val ? 4u : 5u;
+    if(size_t(last-first) < len)
+        return NULL;
+    memcpy(first, s, len);
+    return first+len;
+}
+
+char* printPOD(char *first, char *last, int8 val) { return printSigned(first, last, val); }
+char* printPOD(char *first, char *last, uint8 val) { return printInteger(first, last, val, false); }
+char* printPOD(char *first, char *last, int16_t val) { return printSigned(first, last, val); }
+char* printPOD(char *first, char *last, uint16_t val) { return printInteger(first, last, val, false); }
+char* printPOD(char *first, char *last, int32_t val) { return printSigned(first, last, val); }
+char* printPOD(char *first, char *last, uint32_t val) { return printInteger(first, last, val, false); }
+char* printPOD(char *first, char *last, int64_t val) { return printSigned(first, last, val); }
+char* printPOD(char *first, char *last, uint64_t val) { return printInteger(first, last, val, false); }
+
+char* printPOD(char *first, char *last, float val)
+{
+    return printReal(first, last, val, FLT_DIG, FLT_DIG+3);
+}
+
+char* printPOD(char *first, char *last, double val)
+{
+    return printReal(first, last, val, DBL_DIG, DBL_DIG+2);
+}
+
 }}}
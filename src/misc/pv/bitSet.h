@@ -14,6 +14,13 @@
 #endif
 
 #include <vector>
+#include <iterator>
+#include <algorithm>
+#include <cstddef>
+
+#if defined(_MSC_VER) && defined(_M_X64)
+#  include <intrin.h>
+#endif
 
 #include <pv/pvType.h>
 #include <pv/serialize.h>
@@ -21,11 +28,100 @@
 
 #include <shareLib.h>
 
+/** Number of 64 bit words which a BitSet stores without heap allocation.
+ *
+ * Changes the size of BitSet, so must be the same when building pvDataCPP
+ * and all code which uses it.
+ *
+ * @version Added after 8.0.5
+ */
+#ifndef PVD_BITSET_INLINE_WORDS
+#  define PVD_BITSET_INLINE_WORDS 2
+#endif
+
 namespace epics { namespace pvData { 
 
     class BitSet;
     typedef std::tr1::shared_ptr<BitSet> BitSetPtr;
 
+namespace detail {
+    /* The subset of std::vector<uint64> used by BitSet, with storage for
+     * the first N elements inline.  As with std::vector, capacity is never released.
+     */
+    template<size_t N>
+    class bitset_words {
+        uint64 *m_data; // m_inline or heap
+        size_t m_size, m_cap;
+        uint64 m_inline[N];
+
+        bool onHeap() const { return m_data!=m_inline; }
+
+        void grow(size_t n) {
+            size_t cap = std::max(n, 2u*m_cap);
+            uint64 *temp = new uint64[cap];
+            std::copy(m_data, m_data+m_size, temp);
+            if(onHeap())
+                delete[] m_data;
+            m_data = temp;
+            m_cap = cap;
+        }
+    public:
+        bitset_words() :m_data(m_inline), m_size(0u), m_cap(N) {}
+        bitset_words(const bitset_words& o) :m_data(m_inline), m_size(0u), m_cap(N) { *this = o; }
+        ~bitset_words() {
+            if(onHeap())
+                delete[] m_data;
+        }
+        bitset_words& operator=(const bitset_words& o) {
+            if(this!=&o) {
+                if(o.m_size>m_cap)
+                    grow(o.m_size);
+                std::copy(o.m_data, o.m_data+o.m_size, m_data);
+                m_size = o.m_size;
+            }
+            return *this;
+        }
+
+        void swap(bitset_words& o) {
+            if(onHeap() && o.onHeap()) {
+                std::swap(m_data, o.m_data);
+            } else if(!onHeap() && !o.onHeap()) {
+                std::swap_ranges(m_inline, m_inline+N, o.m_inline);
+            } else {
+                bitset_words& H = onHeap() ? *this : o;
+                bitset_words& I = onHeap() ? o : *this;
+                std::copy(I.m_inline, I.m_inline+N, H.m_inline);
+                I.m_data = H.m_data;
+                H.m_data = H.m_inline;
+            }
+            std::swap(m_size, o.m_size);
+            std::swap(m_cap, o.m_cap);
+        }
+
+        size_t size() const { return m_size; }
+        bool empty() const { return m_size==0u; }
+        uint64* data() { return m_data; }
+        const uint64* data() const { return m_data; }
+        uint64& operator[](size_t i) { return m_data[i]; }
+        const uint64& operator[](size_t i) const { return m_data[i]; }
+        uint64& back() { return m_data[m_size-1u]; }
+        const uint64& back() const { return m_data[m_size-1u]; }
+
+        void reserve(size_t n) {
+            if(n>m_cap)
+                grow(n);
+        }
+        void resize(size_t n, uint64 fill = 0u) {
+            if(n>m_cap)
+                grow(n);
+            if(n>m_size)
+                std::fill(m_data+m_size, m_data+n, fill);
+            m_size = n;
+        }
+        void clear() { m_size = 0u; }
+    };
+} // namespace detail
+
     /**
      * @brief A vector of bits.
      *
@@ -131,6 +227,25 @@ namespace epics { namespace pvData {
          */
         void clear();
 
+        /**
+         * Sets the bits from fromIndex (inclusive) to toIndex (exclusive) to @c true.
+         * @version Added after 8.0.5
+         */
+        BitSet& setRange(uint32 fromIndex, uint32 toIndex);
+
+        /**
+         * Sets the bits from fromIndex (inclusive) to toIndex (exclusive) to @c false.
+         * @version Added after 8.0.5
+         */
+        BitSet& clearRange(uint32 fromIndex, uint32 toIndex);
+
+        /**
+         * Returns true if all bits from fromIndex (inclusive) to toIndex (exclusive) are set.
+         * True for an empty range.
+         * @version Added after 8.0.5
+         */
+        bool allSet(uint32 fromIndex, uint32 toIndex) const;
+
         /**
          * Returns the index of the first bit that is set to @c true that
          * occurs on or after the specified starting index. If no such bit
@@ -254,9 +369,82 @@ namespace epics { namespace pvData {
         virtual void deserialize(ByteBuffer *buffer,
             DeserializableControl *flusher);
 
+        /** @brief Iterates the indices of bits which are set, in increasing order.
+         *
+         * @code
+         * for(BitSet::const_iterator it(bs.begin()), end(bs.end()); it!=end; ++it) {
+         *     uint32 idx = *it;
+         * }
+         * @endcode
+         *
+         * Equivalent to a loop calling nextSetBit(), but does not re-scan for each step.
+         * The BitSet must not be modified while iterating.
+         *
+         * @version Added after 8.0.5
+         */
+        class const_iterator {
+            friend class BitSet;
+            const uint64 *words;
+            size_t nwords;
+            size_t index;   // of the current word
+            uint64 current; // bits of the current word not yet visited.  zero at end()
+
+            const_iterator(const uint64 *words, size_t nwords, size_t index, uint64 current)
+                :words(words), nwords(nwords), index(index), current(current)
+            {
+                if(!current && index<nwords)
+                    advance();
+            }
+
+            void advance() {
+                for(++index; index<nwords; ++index) {
+                    if((current = words[index])!=0u)
+                        return;
+                }
+                current = 0u;
+            }
+        public:
+            typedef std::forward_iterator_tag iterator_category;
+            typedef uint32 value_type;
+            typedef std::ptrdiff_t difference_type;
+            typedef const uint32* pointer;
+            typedef uint32 reference;
+
+            const_iterator() :words(0), nwords(0u), index(0u), current(0u) {}
+
+            inline uint32 operator*() const {
+                return uint32(index*64u) + BitSet::lowestSetBit(current);
+            }
+            inline const_iterator& operator++() {
+                current &= current-1u; // clear lowest set bit
+                if(!current)
+                    advance();
+                return *this;
+            }
+            inline const_iterator operator++(int) {
+                const_iterator ret(*this);
+                ++(*this);
+                return ret;
+            }
+            inline bool operator==(const const_iterator& o) const {
+                return index==o.index && current==o.current;
+            }
+            inline bool operator!=(const const_iterator& o) const { return !(*this==o); }
+        };
+
+        //! Iterator to the lowest set bit
+        //! @version Added after 8.0.5
+        inline const_iterator begin() const {
+            return words.empty() ? end() : const_iterator(words.data(), words.size(), 0u, words[0]);
+        }
+        //! @version Added after 8.0.5
+        inline const_iterator end() const {
+            return const_iterator(0, 0u, words.size(), 0u);
+        }
+
     private:
 
-        typedef std::vector<uint64> words_t;
+        typedef detail::bitset_words<PVD_BITSET_INLINE_WORDS> words_t;
         /** The internal field corresponding to the serialField "bits". */
         words_t words;
 
@@ -307,6 +495,19 @@ namespace epics { namespace pvData {
          */
          static uint32 bitCount(uint64 i);
 
+        //! numberOfTrailingZeros() for non-zero i
+        static inline uint32 lowestSetBit(uint64 i) {
+#if defined(__GNUC__)
+            return __builtin_ctzll(i);
+#elif defined(_MSC_VER) && defined(_M_X64)
+            unsigned long ret;
+            _BitScanForward64(&ret, i);
+            return ret;
+#else
+            return numberOfTrailingZeros(i);
+#endif
+        }
+
     };
     
     epicsShareExtern std::ostream& operator<<(std::ostream& o, const BitSet& b);
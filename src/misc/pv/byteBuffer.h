@@ -201,6 +201,41 @@ EPICS_ALWAYS_INLINE T load_unaligned(const char *buf)
 
 #endif /* alignement */
 
+/* Copy an array of 'count' elements of 2, 4, or 8 bytes, reversing the
+ * byte order of each element.  'dest' and 'src' need not be aligned,
+ * and must not overlap.  Vectorized where supported.
+ */
+epicsShareExtern void swap_copy2(char *dest, const char *src, std::size_t count);
+epicsShareExtern void swap_copy4(char *dest, const char *src, std::size_t count);
+epicsShareExtern void swap_copy8(char *dest, const char *src, std::size_t count);
+
+template<unsigned N>
+struct swap_copy; // no default
+template<>
+struct swap_copy<1> {
+    static EPICS_ALWAYS_INLINE void op(char *dest, const char *src, std::size_t count) {
+        memcpy(dest, src, count);
+    }
+};
+template<>
+struct swap_copy<2> {
+    static EPICS_ALWAYS_INLINE void op(char *dest, const char *src, std::size_t count) {
+        swap_copy2(dest, src, count);
+    }
+};
+template<>
+struct swap_copy<4> {
+    static EPICS_ALWAYS_INLINE void op(char *dest, const char *src, std::size_t count) {
+        swap_copy4(dest, src, count);
+    }
+};
+template<>
+struct swap_copy<8> {
+    static EPICS_ALWAYS_INLINE void op(char *dest, const char *src, std::size_t count) {
+        swap_copy8(dest, src, count);
+    }
+};
+
 } // namespace detail
 
 //! Unconditional byte order swap.
@@ -787,9 +822,7 @@ private:
         assert(n<=getRemaining());
 
         if (reverse<T>()) {
-            for(std::size_t i=0; i<count; i++) {
-                detail::store_unaligned(_position+i*sizeof(T), swap<T>(values[i]));
-            }
+            detail::swap_copy<sizeof(T)>::op(_position, (const char*)values, count);
         } else {
             memcpy(_position, values, n);
         }
@@ -803,9 +836,7 @@ private:
         assert(n<=getRemaining());
 
         if (reverse<T>()) {
-            for(std::size_t i=0; i<count; i++) {
-                values[i] = swap<T>(detail::load_unaligned<T>(_position+i*sizeof(T)));
-            }
+            detail::swap_copy<sizeof(T)>::op((char*)values, _position, count);
         } else {
             memcpy(values, _position, n);
         }
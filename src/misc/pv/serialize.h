@@ -9,10 +9,13 @@
 #ifndef SERIALIZE_H
 #define SERIALIZE_H
 
+#include <vector>
+
 #include <epicsTypes.h>
 
 #include <pv/byteBuffer.h>
 #include <pv/sharedPtr.h>
+#include <pv/noDefaultMethods.h>
 
 #include <shareLib.h>
 
@@ -75,6 +78,28 @@ namespace epics { namespace pvData {
             const char* toSerialize,
             std::size_t elementCount,
             std::size_t elementSize) = 0;
+        /**
+         * As directSerialize(), with a reference to the array storage.
+         * Implementations may retain 'owner' in order to output the
+         * array values after serialize() has returned.
+         * The default calls directSerialize().
+         * @param existingBuffer the existing buffer from the caller.
+         * @param toSerialize location of data to be put into buffer.
+         * @param elementCount number of elements.
+         * @param elementSize element size.
+         * @param owner keeps toSerialize valid.  Array storage is not modified while referenced.
+         * @returns true if serialization performed, else false.
+         * @version Added after 8.0.5
+         */
+        virtual bool directSerializeRef(
+            ByteBuffer *existingBuffer,
+            const char* toSerialize,
+            std::size_t elementCount,
+            std::size_t elementSize,
+            const std::tr1::shared_ptr<const void>& owner)
+        {
+            return directSerialize(existingBuffer, toSerialize, elementCount, elementSize);
+        }
         /**
          * serialize via cache
          * @param field instance to be serialized
@@ -123,6 +148,33 @@ namespace epics { namespace pvData {
             char* deserializeTo,
             std::size_t elementCount,
             std::size_t elementSize) = 0;
+        /**
+         * Method for deserializing array data by reference.
+         * Called before directDeserialize(), and only when no byte order
+         * swapping is needed.
+         * If the storage of existingBuffer is reference counted,
+         * will not be modified afterwards,
+         * and holds all elementCount*elementSize bytes from the current position,
+         * then set 'owner' to a reference which keeps this storage alive
+         * and return true.
+         * The caller then uses the array values in place,
+         * and advances the position of existingBuffer.
+         * The default returns false.
+         * @param existingBuffer the existing buffer from the caller.
+         * @param elementCount number of elements.
+         * @param elementSize element size.
+         * @param owner set to a reference to the storage of existingBuffer.
+         * @returns true if the array values may be referenced.
+         * @version Added after 8.0.5
+         */
+        virtual bool directDeserializeRef(
+            ByteBuffer *existingBuffer,
+            std::size_t elementCount,
+            std::size_t elementSize,
+            std::tr1::shared_ptr<const void>& owner)
+        {
+            return false;
+        }
         /**
          * deserialize via cache
          * @param buffer buffer to be deserialized from
@@ -169,6 +221,91 @@ namespace epics { namespace pvData {
                            int byteOrder,
                            std::vector<epicsUInt8>& out);
 
+    /**
+     * @brief Serialized output as a list of segments, suitable for writev() or sendmsg()
+     *
+     * Header bytes are copied into staging storage owned by this object.
+     * Primitive array values which need no byte order swapping,
+     * and are at least minReference bytes long, are not copied.
+     * Instead a segment refers to the array storage,
+     * which is kept alive by a reference held until clear().
+     *
+     * @code
+     *   SerializedSegments segs;
+     *   segs.serialize(pvStructure.get(), EPICS_BYTE_ORDER);
+     *   std::vector<struct iovec> iov(segs.segments().size());
+     *   for(size_t i=0; i<iov.size(); i++) {
+     *       iov[i].iov_base = (void*)segs.segments()[i].base;
+     *       iov[i].iov_len = segs.segments()[i].len;
+     *   }
+     *   writev(fd, &iov[0], iov.size());
+     * @endcode
+     *
+     * No caching is done.  Only complete serialization.
+     *
+     * @version Added after 8.0.5
+     */
+    class epicsShareClass SerializedSegments {
+        EPICS_NOT_COPYABLE(SerializedSegments)
+    public:
+        //! A contiguous region of output
+        struct Segment {
+            const void *base;
+            std::size_t len;
+        };
+        typedef std::vector<Segment> segments_t;
+
+        /**
+         * @param minReference Arrays smaller than this many bytes are copied
+         */
+        explicit SerializedSegments(std::size_t minReference = 1024u);
+        ~SerializedSegments();
+
+        /**
+         * @brief Push serialize and append to the segment list.
+         * @param S A Serializable object
+         * @param byteOrder Byte order to write (EPICS_ENDIAN_LITTLE or EPICS_ENDIAN_BIG)
+         */
+        void serialize(const Serializable *S, int byteOrder = EPICS_BYTE_ORDER);
+
+        //! Release staging storage and array references
+        void clear();
+
+        //! Segments in output order.  Valid until the next serialize() or clear().
+        inline const segments_t& segments() const { return segs; }
+        //! Total number of bytes in all segments
+        inline std::size_t size() const { return total; }
+        //! Number of array values referenced instead of copied
+        inline std::size_t referenceCount() const { return refs.size(); }
+
+        //! Append the contents of all segments to a contiguous vector
+        void copyTo(std::vector<epicsUInt8>& out) const;
+
+    private:
+        struct Control;
+        // staging.size() at the start of each staged segment,
+        // or (size_t)-1 for referenced segments.
+        std::vector<std::size_t> offsets;
+        std::vector<char> staging;
+        segments_t segs;
+        std::vector<std::tr1::shared_ptr<const void> > refs;
+        std::size_t total;
+        const std::size_t minReference;
+    };
+
+    /**
+     * @brief Number of bytes which S->serialize() would write.
+     *
+     * Generic, and exact, but performs a complete serialization pass
+     * (skipping array values) without output.
+     * Prefer Field::getSerializedSize() or PVField::getSerializedSize()
+     * where applicable.
+     *
+     * @param S A Serializable object
+     * @version Added after 8.0.5
+     */
+    std::size_t epicsShareFunc getSerializedSize(const Serializable *S);
+
     /**
      * @brief deserializeFromBuffer Deserialize into S from provided vector
      * @param S A Serializeable object.  The current contents will be replaced
@@ -178,6 +315,22 @@ namespace epics { namespace pvData {
     void epicsShareFunc deserializeFromBuffer(Serializable *S,
                                ByteBuffer& in);
 
+    /**
+     * @brief deserializeFromBuffer Deserialize into S from a reference counted buffer
+     *
+     * Primitive array values which need no byte order swapping, and are suitably aligned,
+     * are not copied.  They refer to the storage of 'in', and hold a reference to 'owner'.
+     *
+     * @param S A Serializeable object.  The current contents will be replaced
+     * @param in The input buffer (byte order of this buffer is used)
+     * @param owner Keeps the storage of 'in' alive.  This storage must not be modified afterwards.
+     * @throws std::logic_error if input buffer is too small.  State of S is then undefined.
+     * @version Added after 8.0.5
+     */
+    void epicsShareFunc deserializeFromBuffer(Serializable *S,
+                               ByteBuffer& in,
+                               const std::tr1::shared_ptr<const void>& owner);
+
     /**
      * @brief deserializeFromBuffer Deserialize into S from provided vector
      * @param S A Serializeable object.  The current contents will be replaced
@@ -95,6 +95,26 @@ namespace epics {
             static std::string deserializeString(ByteBuffer* buffer,
                     DeserializableControl* control);
 
+            /**
+             * Number of bytes which writeSize() will write.
+             *
+             * @param[in] s size to encode
+             * @version Added after 8.0.5
+             */
+            static inline std::size_t sizeOfSize(std::size_t s) {
+                return (s==(std::size_t)-1 || s<254) ? 1u : 5u;
+            }
+
+            /**
+             * Number of bytes which serializeString() will write.
+             *
+             * @param[in] value std::string to serialize
+             * @version Added after 8.0.5
+             */
+            static inline std::size_t sizeOfString(const std::string& value) {
+                return sizeOfSize(value.size()) + value.size();
+            }
+
         private:
             SerializeHelper() {};
             ~SerializeHelper() {};
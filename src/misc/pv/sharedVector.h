@@ -383,7 +383,10 @@ public:
         :base_t(std::tr1::static_pointer_cast<E>(src.dataPtr()),
                 src.dataOffset()/sizeof(E),
                 src.dataCount()/sizeof(E))
-    {}
+    {
+        // preserve capacity so that a round trip through void doesn't force a copy
+        this->m_total = src.dataTotal()/sizeof(E);
+    }
 
 
     shared_vector(shared_vector<typename base_t::_E_non_const>& O,
@@ -701,7 +704,9 @@ public:
                 src.dataOffset()*sizeof(FROM),
                 src.dataCount()*sizeof(FROM))
         ,m_vtype((ScalarType)ScalarTypeID<FROM>::value)
-    {}
+    {
+        this->m_total = src.dataTotal()*sizeof(FROM);
+    }
 
     shared_vector(shared_vector<void>& O,
                   detail::_shared_vector_freeze_tag t)
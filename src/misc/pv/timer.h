@@ -10,6 +10,8 @@
 #define TIMER_H
 #include <memory>
 #include <list>
+#include <deque>
+#include <vector>
 
 #include <stddef.h>
 #include <stdlib.h>
@@ -33,6 +35,37 @@ class Timer;
 typedef std::tr1::shared_ptr<TimerCallback> TimerCallbackPtr;
 typedef std::tr1::shared_ptr<Timer> TimerPtr;
 
+/**
+ * @brief Delay between the scheduled, and actual, start of TimerCallback::callback()
+ *
+ * @version Added after 8.0.5
+ */
+struct TimerLateness {
+    //! Number of calls
+    size_t count;
+    //! Sum of lateness in seconds
+    double total;
+    //! Largest lateness in seconds
+    double max;
+    //! Periods skipped by a periodic callback with Timer::Config::coalesce(),
+    //! or without Timer::Config::serialize()
+    size_t missed;
+
+    /** Number of calls by lateness.  Decades from 10 us.
+     *  histogram[0] counts calls less than 10 us late, histogram[1] less than 100 us,
+     *  ... histogram[5] less than 1 s, and histogram[6] all others.
+     */
+    enum { NBins = 7 };
+    size_t histogram[NBins];
+
+    TimerLateness() :count(0u), total(0.0), max(0.0), missed(0u) {
+        for(size_t i=0; i<NBins; i++)
+            histogram[i] = 0u;
+    }
+    //! Mean lateness in seconds
+    double mean() const { return count ? total/count : 0.0; }
+};
+
 /**
  * @brief Class that must be implemented by code that makes Timer requests.
  *
@@ -57,9 +90,20 @@ public:
      */
     virtual void timerStopped() = 0;
 private:
-    epicsTime timeToRun;
-    double period;
+    // nanoseconds, on the Timer's monotonic clock
+    uint64 timeToRun;
+    // nanoseconds.  zero if not periodic
+    uint64 period;
     bool onList;
+    // position in Timer::queue while onList
+    size_t heapIndex;
+    // order of scheduling, to break ties in timeToRun
+    uint64 sequence;
+    // number of calls in progress on Timer workers
+    unsigned running;
+    // expired while running, with Timer::Config::serialize()
+    bool rerun;
+    TimerLateness lateness;
     friend class Timer;
     struct IncreasingTime;
 };
@@ -67,15 +111,75 @@ private:
 /**
  * @brief Support for delayed or periodic callback execution.
  *
+ * Pending callbacks are kept in a binary heap ordered by expiration time.
+ * Scheduling and cancel() are O(log n), and isScheduled() is O(1),
+ * in the number of pending callbacks.
+ * Callbacks which expire at the same time are run in the order
+ * in which they were scheduled.
+ *
+ * Expiration times are kept on a monotonic clock (EPICS Base >= 3.15), so changes to
+ * the system time do not affect delays or periods.
+ * A periodic callback is re-scheduled relative to its previous expiration
+ * time, not the time when it ran, so its period does not drift.
+ * When a periodic callback falls behind by more than one period, the missed
+ * periods are run back to back, unless Config::coalesce() is set.
+ *
+ * By default callbacks are run by the single timer thread.
+ * A Timer created with Config::workers() instead hands expired callbacks
+ * to a pool of worker threads, so that a slow callback doesn't delay others.
  */
 class epicsShareClass Timer : private Runnable {
 public:
     POINTER_DEFINITIONS(Timer);
+
+    /** @brief Options for a Timer
+     *
+     * @code
+     *   Timer timer(Timer::Config("scan")
+     *                   .prio(highPriority)
+     *                   .workers(4));
+     * @endcode
+     *
+     * @version Added after 8.0.5
+     */
+    class epicsShareClass Config {
+        std::string p_name;
+        ThreadPriority p_prio;
+        size_t p_workers;
+        bool p_serialize;
+        bool p_coalesce;
+        friend class Timer;
+    public:
+        //! @param name Name of the timer thread.  Worker threads are named name-N
+        explicit Config(const std::string& name);
+        //! Priority of timer and worker threads.  Default middlePriority.
+        Config& prio(ThreadPriority p);
+        //! Number of worker threads.  Default 0 runs callbacks on the timer thread.
+        Config& workers(size_t n);
+        /** If true (the default), a callback is never run concurrently with itself.
+         *  A periodic callback is re-scheduled when it completes, and a callback
+         *  which expires while still running is run again after it completes.
+         *  If false, a periodic callback is re-scheduled when dispatched to a worker.
+         *  A period which expires while as many calls are queued or running as
+         *  there are workers is skipped, and counted in TimerLateness::missed.
+         */
+        Config& serialize(bool s);
+        /** If true, a periodic callback which has fallen behind by more than one
+         *  period is run only once, and then re-scheduled for the next period
+         *  which has not yet expired.  Default false, the missed periods are run.
+         */
+        Config& coalesce(bool c);
+    };
+
     /** Create a new timer queue
      * @param threadName name for the timer thread.
      * @param priority thread priority
      */
     Timer(std::string threadName, ThreadPriority priority);
+    /** Create a new timer queue
+     * @version Added after 8.0.5
+     */
+    explicit Timer(const Config& conf);
     virtual ~Timer();
     //! Prevent new callbacks from being scheduled, and cancel pending callbacks
     void close();
@@ -101,6 +205,9 @@ public:
      * cancel a callback.
      * @param timerCallback the timerCallback to cancel.
      * @returns true if the timer was queued, and now is cancelled
+     *
+     * With Config::workers() and Config::serialize(), a periodic callback
+     * which is currently running will not be re-scheduled.
      */
     bool cancel(TimerCallbackPtr const &timerCallback);
     /**
@@ -110,24 +217,56 @@ public:
      */
     bool isScheduled(TimerCallbackPtr const &timerCallback) const;
     /**
-     * show the elements in the timer queue.
+     * Statistics of how late timerCallback has been run.
+     * These are kept with the TimerCallback, so they include calls by
+     * any other Timer with which it has been scheduled.
+     * @version Added after 8.0.5
+     */
+    TimerLateness getLateness(TimerCallbackPtr const &timerCallback) const;
+    /**
+     * show the elements in the timer queue,
+     * and a histogram of the lateness of all callbacks.
      * @param o The output stream for the output
      */
     void dump(std::ostream& o) const;
 
 private:
     virtual void run();
+    // worker thread main
+    void work();
 
     // call with mutex held
     void addElement(TimerCallbackPtr const &timerCallback);
+    void removeElement(size_t index);
+    void siftUp(size_t index);
+    void siftDown(size_t index);
+    void dispatch(TimerCallbackPtr const &timerCallback);
+    void completed(TimerCallbackPtr const &timerCallback, uint64 due, uint64 start);
+    void reschedule(TimerCallbackPtr const &timerCallback);
 
-    typedef std::list<TimerCallbackPtr> queue_t;
+    // binary heap.  front() expires first
+    typedef std::vector<TimerCallbackPtr> queue_t;
 
     mutable Mutex mutex;
     queue_t queue;
+    uint64 nextSequence;
     Event waitForWork;
     bool waiting;
     bool alive;
+    const bool serialize;
+    const bool coalesce;
+    // of all callbacks
+    TimerLateness lateness;
+
+    // expired callbacks waiting for a worker
+    struct Ready {
+        TimerCallbackPtr callback;
+        uint64 due;
+    };
+    std::deque<Ready> ready;
+    Event readyWork;
+    std::vector<ThreadPtr> workers;
+
     Thread thread;
 };
 
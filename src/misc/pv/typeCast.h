@@ -46,6 +46,25 @@ namespace detail {
     static inline void parseToPOD(const std::string& str, float *out) { return parseToPOD(str.c_str(), out); }
     static inline void parseToPOD(const std::string& str, double *out) { return parseToPOD(str.c_str(), out); }
 
+    //! Buffer size sufficient for any printPOD()
+    enum { printPODMaxLen = 32 };
+
+    // printPOD formats a value without allocating, and without regard to locale.
+    // float and double are printed with the fewest digits which parse back
+    // to the same value.  Writes [first, returned) without a trailing nil.
+    // Returns NULL if the buffer is too small.
+    epicsShareExtern char* printPOD(char *first, char *last, boolean val);
+    epicsShareExtern char* printPOD(char *first, char *last, int8 val);
+    epicsShareExtern char* printPOD(char *first, char *last, uint8 val);
+    epicsShareExtern char* printPOD(char *first, char *last, int16_t val);
+    epicsShareExtern char* printPOD(char *first, char *last, uint16_t val);
+    epicsShareExtern char* printPOD(char *first, char *last, int32_t val);
+    epicsShareExtern char* printPOD(char *first, char *last, uint32_t val);
+    epicsShareExtern char* printPOD(char *first, char *last, int64_t val);
+    epicsShareExtern char* printPOD(char *first, char *last, uint64_t val);
+    epicsShareExtern char* printPOD(char *first, char *last, float val);
+    epicsShareExtern char* printPOD(char *first, char *last, double val);
+
     /* want to pass POD types by value,
      * and std::string by const reference
      */
@@ -96,10 +115,51 @@ namespace detail {
         }
     };
 
+    // Select how to print a type.
+    // print_direct<T>::type is defined only for types with a printPOD() overload.
+    // print_stream<T>::type is defined for all others, except std::string
+    template<typename T, class R = void> struct print_direct {};
+    template<typename T, class R = void> struct print_stream { typedef R type; };
+    template<class R> struct print_stream<std::string, R> {};
+#define PRINT_DIRECT(TYPE) \
+    template<class R> struct print_direct<TYPE, R> { typedef R type; }; \
+    template<class R> struct print_stream<TYPE, R> {};
+    PRINT_DIRECT(boolean)
+    PRINT_DIRECT(int8)
+    PRINT_DIRECT(uint8)
+    PRINT_DIRECT(int16)
+    PRINT_DIRECT(uint16)
+    PRINT_DIRECT(int32)
+    PRINT_DIRECT(uint32)
+    PRINT_DIRECT(int64)
+    PRINT_DIRECT(uint64)
+    PRINT_DIRECT(float)
+    PRINT_DIRECT(double)
+#undef PRINT_DIRECT
+
     // print POD to string
+    template<typename FROM>
+    struct cast_helper<std::string, FROM, typename print_direct<FROM>::type> {
+        static std::string op(FROM from) {
+            char buf[printPODMaxLen];
+            char *end = printPOD(buf, buf+sizeof(buf), from);
+            if(!end)
+                throw std::runtime_error("Cast to string failed");
+            return std::string(buf, end);
+        }
+    };
+
+    template<>
+    struct cast_helper<std::string, const char*> {
+        static FORCE_INLINE std::string op(const char* from) {
+            return std::string(from);
+        }
+    };
+
+    // print any other type std::ostream understands
     // when std::string!=FROM
     template<typename FROM>
-    struct cast_helper<std::string, FROM, typename meta::not_same_type<std::string,FROM>::type> {
+    struct cast_helper<std::string, FROM, typename print_stream<FROM>::type> {
         static std::string op(FROM from) {
             std::ostringstream strm;
             strm << print_convolute<FROM>::op(from);
@@ -190,6 +250,10 @@ namespace detail {
  * - Numbers beginning with '0' are parsed as base-8.
  * - Hex numbers are case insensitive.
  * - Exponential numbers may use either 'e' or 'E'.
+ *
+ * float and double are printed with the fewest digits needed to
+ * parse back to the same value (eg. "0.1" and not "0.10000000000000001").
+ * Neither printing, nor parsing of typical decimal numbers, depends on the C locale.
  */
 template<typename TO, typename FROM>
 static FORCE_INLINE TO castUnsafe(const FROM& from)
@@ -197,6 +261,13 @@ static FORCE_INLINE TO castUnsafe(const FROM& from)
     return detail::cast_helper<TO,FROM>::op(from);
 }
 
+/** @brief Cast an array of count elements of type 'from' into an array of type 'to'.
+ *
+ * Each element is converted as by castUnsafe().
+ * The source and destination arrays must not overlap.
+ *
+ @throws std::runtime_error when an element can not be converted.
+ */
 epicsShareExtern void castUnsafeV(size_t count, ScalarType to, void *dest, ScalarType from, const void *src);
 
 //! Cast value to printable type
@@ -19,6 +19,7 @@
 #include <pv/epicsException.h>
 #include <pv/byteBuffer.h>
 #include <pv/serializeHelper.h>
+#include <pv/pvData.h>
 
 using namespace std;
 
@@ -160,17 +161,17 @@ struct ToString : public epics::pvData::SerializableControl
 
     virtual void flushSerializeBuffer()
     {
-        size_t N = out.size();
-        out.resize(out.size()+bufwrap.getPosition());
-        std::copy(buf.begin(),
-                  buf.begin()+bufwrap.getPosition(),
-                  out.begin()+N);
+        // vector::insert() grows geometrically
+        out.insert(out.end(),
+                   buf.begin(),
+                   buf.begin()+bufwrap.getPosition());
         bufwrap.clear();
     }
 
     virtual void ensureBuffer(std::size_t size)
     {
-        flushSerializeBuffer();
+        if(bufwrap.getRemaining()<size)
+            flushSerializeBuffer();
         assert(bufwrap.getRemaining()>0);
     }
 
@@ -180,7 +181,61 @@ struct ToString : public epics::pvData::SerializableControl
         std::size_t elementCount,
         std::size_t elementSize)
     {
-        return false;
+        const std::size_t n = elementCount*elementSize;
+        // small arrays are copied into the staging buffer
+        if(n<=bufwrap.getRemaining())
+            return false;
+
+        // copy directly to output
+        flushSerializeBuffer();
+        out.insert(out.end(), (const epicsUInt8*)toSerialize, (const epicsUInt8*)toSerialize+n);
+        return true;
+    }
+
+    virtual void cachedSerialize(
+        std::tr1::shared_ptr<const Field> const & field,
+        ByteBuffer* buffer)
+    {
+        field->serialize(buffer, this);
+    }
+};
+
+// Counts the bytes which would be serialized.
+// Native byte order so that all primitive arrays are passed to directSerialize().
+// Same size as ToString::buf, as some callers ensureBuffer() large blocks.
+struct CountBytes : public epics::pvData::SerializableControl
+{
+    char scratch[16*1024];
+    ByteBuffer bufwrap;
+    std::size_t count;
+
+    CountBytes()
+        :bufwrap(scratch, sizeof(scratch))
+        ,count(0u)
+    {}
+
+    std::size_t total() const { return count + bufwrap.getPosition(); }
+
+    virtual void flushSerializeBuffer()
+    {
+        count += bufwrap.getPosition();
+        bufwrap.clear();
+    }
+
+    virtual void ensureBuffer(std::size_t size)
+    {
+        if(bufwrap.getRemaining()<size)
+            flushSerializeBuffer();
+    }
+
+    virtual bool directSerialize(
+        ByteBuffer *existingBuffer,
+        const char* toSerialize,
+        std::size_t elementCount,
+        std::size_t elementSize)
+    {
+        count += elementCount*elementSize;
+        return true;
     }
 
     virtual void cachedSerialize(
@@ -195,10 +250,140 @@ struct ToString : public epics::pvData::SerializableControl
 
 namespace epics {
     namespace pvData {
+
+        struct SerializedSegments::Control : public SerializableControl
+        {
+            SerializedSegments& self;
+            char scratch[16*1024];
+            ByteBuffer bufwrap;
+
+            Control(SerializedSegments& self, int byteOrder)
+                :self(self)
+                ,bufwrap(scratch, sizeof(scratch), byteOrder)
+            {}
+
+            virtual void flushSerializeBuffer()
+            {
+                const std::size_t n = bufwrap.getPosition();
+                if(n==0)
+                    return;
+                if(self.offsets.empty() || self.offsets.back()==(std::size_t)-1) {
+                    // start a new staged segment.  base filled in later
+                    SerializedSegments::Segment seg = {0, 0u};
+                    self.segs.push_back(seg);
+                    self.offsets.push_back(self.staging.size());
+                }
+                self.staging.insert(self.staging.end(), scratch, scratch+n);
+                self.segs.back().len += n;
+                self.total += n;
+                bufwrap.clear();
+            }
+
+            virtual void ensureBuffer(std::size_t size)
+            {
+                if(bufwrap.getRemaining()<size)
+                    flushSerializeBuffer();
+                assert(bufwrap.getRemaining()>0);
+            }
+
+            virtual bool directSerialize(
+                ByteBuffer *existingBuffer,
+                const char* toSerialize,
+                std::size_t elementCount,
+                std::size_t elementSize)
+            {
+                return false; // can't reference without an owner, so copy
+            }
+
+            virtual bool directSerializeRef(
+                ByteBuffer *existingBuffer,
+                const char* toSerialize,
+                std::size_t elementCount,
+                std::size_t elementSize,
+                const std::tr1::shared_ptr<const void>& owner)
+            {
+                const std::size_t n = elementCount*elementSize;
+                if(!owner || n<self.minReference)
+                    return false;
+
+                flushSerializeBuffer();
+                SerializedSegments::Segment seg = {toSerialize, n};
+                self.segs.push_back(seg);
+                self.offsets.push_back((std::size_t)-1);
+                self.refs.push_back(owner);
+                self.total += n;
+                return true;
+            }
+
+            virtual void cachedSerialize(
+                std::tr1::shared_ptr<const Field> const & field,
+                ByteBuffer* buffer)
+            {
+                field->serialize(buffer, this);
+            }
+        };
+
+        SerializedSegments::SerializedSegments(std::size_t minReference)
+            :total(0u)
+            ,minReference(minReference)
+        {}
+
+        SerializedSegments::~SerializedSegments() {}
+
+        void SerializedSegments::serialize(const Serializable *S, int byteOrder)
+        {
+            {
+                Control C(*this, byteOrder);
+                S->serialize(&C.bufwrap, &C);
+                C.flushSerializeBuffer();
+            }
+
+            // staging is now complete, so pointers into it are stable
+            for(std::size_t i=0, N=segs.size(); i<N; i++) {
+                if(offsets[i]!=(std::size_t)-1)
+                    segs[i].base = &staging[offsets[i]];
+            }
+        }
+
+        void SerializedSegments::clear()
+        {
+            offsets.clear();
+            staging.clear();
+            segs.clear();
+            refs.clear();
+            total = 0u;
+        }
+
+        void SerializedSegments::copyTo(std::vector<epicsUInt8>& out) const
+        {
+            out.reserve(out.size()+total);
+            for(std::size_t i=0, N=segs.size(); i<N; i++) {
+                const epicsUInt8 *base = (const epicsUInt8*)segs[i].base;
+                out.insert(out.end(), base, base+segs[i].len);
+            }
+        }
+
+        std::size_t getSerializedSize(const Serializable *S)
+        {
+            CountBytes C;
+            S->serialize(&C.bufwrap, &C);
+            return C.total();
+        }
+
         void serializeToVector(const Serializable *S,
                                int byteOrder,
                                std::vector<epicsUInt8>& out)
         {
+            {
+                // size pre-pass so that 'out' is only (re)allocated once.
+                std::size_t size;
+                if(const PVField *fld = dynamic_cast<const PVField*>(S))
+                    size = fld->getSerializedSize();
+                else
+                    size = getSerializedSize(S);
+                out.reserve(out.size()+size);
+            }
+
             ToString TS(out, byteOrder);
             S->serialize(&TS.bufwrap, &TS);
             TS.flushSerializeBuffer();
@@ -212,10 +397,12 @@ struct FromString : public epics::pvData::DeserializableControl
 {
     ByteBuffer &buf;
     epics::pvData::FieldCreatePtr create;
+    const std::tr1::shared_ptr<const void> owner;
 
-    FromString(ByteBuffer& b)
+    FromString(ByteBuffer& b, const std::tr1::shared_ptr<const void>& owner = std::tr1::shared_ptr<const void>())
         :buf(b)
         ,create(epics::pvData::getFieldCreate())
+        ,owner(owner)
     {}
 
     virtual void ensureData(std::size_t size)
@@ -232,6 +419,17 @@ struct FromString : public epics::pvData::DeserializableControl
     {
         return false;
     }
+    virtual bool directDeserializeRef(
+        ByteBuffer *existingBuffer,
+        std::size_t elementCount,
+        std::size_t elementSize,
+        std::tr1::shared_ptr<const void>& ref)
+    {
+        if(!owner || elementCount*elementSize>buf.getRemaining())
+            return false;
+        ref = owner;
+        return true;
+    }
     virtual std::tr1::shared_ptr<const Field> cachedDeserialize(
         ByteBuffer* buffer)
     {
@@ -248,5 +446,13 @@ namespace epics {
             FromString F(buf);
             S->deserialize(&buf, &F);
         }
+
+        void deserializeFromBuffer(Serializable *S,
+                                   ByteBuffer& buf,
+                                   const std::tr1::shared_ptr<const void>& owner)
+        {
+            FromString F(buf, owner);
+            S->deserialize(&buf, &F);
+        }
     }
 }
@@ -10,77 +10,380 @@
 #include <stdexcept>
 #include <string>
 #include <iostream>
+#include <algorithm>
 
 #include <epicsThread.h>
 #include <epicsGuard.h>
+#include <epicsTime.h>
 
 #define epicsExportSharedSymbols
+#include <pv/pvdVersion.h>
 #include <pv/timer.h>
 
 using std::string;
 
 namespace epics { namespace pvData {
 
+typedef epicsGuard<epicsMutex> Guard;
+typedef epicsGuardRelease<epicsMutex> UnGuard;
+
+namespace {
+using epics::pvData::uint64;
+
+// nanoseconds on a clock which isn't affected by changes to the system time
+uint64 monotonicNow()
+{
+#if EPICS_VERSION_INT>=VERSION_INT(3,15,0,2)
+    return epicsMonotonicGet();
+#else
+    epicsTimeStamp now;
+    epicsTimeGetCurrent(&now);
+    return uint64(now.secPastEpoch)*1000000000u + now.nsec;
+#endif
+}
+
+// a deadline which is never reached
+const uint64 never = ~uint64(0u);
+
+// seconds to nanoseconds.  negative (and NaN) as zero.
+// positive as at least 1ns, so that a short period remains periodic.
+// too large to represent (eg. Inf) as never.
+uint64 toNS(double sec)
+{
+    const double ns = sec*1e9;
+    if(!(ns > 0.0))
+        return 0u;
+    else if(ns >= double(never)) // 2**64
+        return never;
+    else if(ns < 1.0)
+        return 1u;
+    return uint64(ns);
+}
+
+// time + ns, saturating at never
+uint64 addNS(uint64 time, uint64 ns)
+{
+    return ns < never - time ? time + ns : never;
+}
+
+double toSec(uint64 ns)
+{
+    return ns*1e-9;
+}
+
+// seconds between a and b, negative if b is before a
+double diffSec(uint64 b, uint64 a)
+{
+    return b>=a ? toSec(b-a) : -toSec(a-b);
+}
+
+} // namespace
+
 TimerCallback::TimerCallback()
-: period(0.0),
-  onList(false)
+: timeToRun(0u),
+  period(0u),
+  onList(false),
+  heapIndex(0u),
+  sequence(0u),
+  running(0u),
+  rerun(false)
 {
 }
 
+Timer::Config::Config(const std::string& name)
+    :p_name(name)
+    ,p_prio(middlePriority)
+    ,p_workers(0u)
+    ,p_serialize(true)
+    ,p_coalesce(false)
+{}
+
+Timer::Config& Timer::Config::prio(ThreadPriority p) { p_prio = p; return *this; }
+Timer::Config& Timer::Config::workers(size_t n) { p_workers = n; return *this; }
+Timer::Config& Timer::Config::serialize(bool s) { p_serialize = s; return *this; }
+Timer::Config& Timer::Config::coalesce(bool c) { p_coalesce = c; return *this; }
+
 Timer::Timer(string threadName,ThreadPriority priority)
-    :waitForWork(false)
+    :nextSequence(0u)
+    ,waitForWork(false)
     ,waiting(false)
     ,alive(true)
+    ,serialize(true)
+    ,coalesce(false)
+    ,readyWork(false)
     ,thread(threadName,priority,this)
 {}
 
+Timer::Timer(const Config& conf)
+    :nextSequence(0u)
+    ,waitForWork(false)
+    ,waiting(false)
+    ,alive(true)
+    ,serialize(conf.p_serialize)
+    ,coalesce(conf.p_coalesce)
+    ,readyWork(false)
+    ,thread(conf.p_name,conf.p_prio,this)
+{
+    try {
+        Lock xx(mutex);
+        workers.reserve(conf.p_workers);
+        for(size_t i=0; i<conf.p_workers; i++) {
+            Thread::Config tconf(this, &Timer::work);
+            tconf.prio(conf.p_prio)
+                 <<conf.p_name<<'-'<<i;
+            workers.push_back(ThreadPtr(new Thread(tconf)));
+        }
+    } catch(...) {
+        close();
+        throw;
+    }
+}
+
 struct TimerCallback::IncreasingTime {
-    bool operator()(const TimerCallbackPtr& lhs, const TimerCallbackPtr& rhs) {
+    bool operator()(const TimerCallbackPtr& lhs, const TimerCallbackPtr& rhs) const {
         assert(lhs && rhs);
-        return lhs->timeToRun < rhs->timeToRun;
+        if(lhs->timeToRun < rhs->timeToRun)
+            return true;
+        else if(rhs->timeToRun < lhs->timeToRun)
+            return false;
+        return lhs->sequence < rhs->sequence;
     }
 };
 
+// call with mutex held
+void Timer::siftUp(size_t index)
+{
+    TimerCallback::IncreasingTime before;
+    TimerCallbackPtr temp;
+    temp.swap(queue[index]);
+
+    while(index>0u) {
+        size_t parent = (index-1u)/2u;
+        if(!before(temp, queue[parent]))
+            break;
+        queue[index].swap(queue[parent]);
+        queue[index]->heapIndex = index;
+        index = parent;
+    }
+
+    queue[index].swap(temp);
+    queue[index]->heapIndex = index;
+}
+
+// call with mutex held
+void Timer::siftDown(size_t index)
+{
+    TimerCallback::IncreasingTime before;
+    const size_t N = queue.size();
+    TimerCallbackPtr temp;
+    temp.swap(queue[index]);
+
+    while(true) {
+        size_t child = 2u*index+1u;
+        if(child>=N)
+            break;
+        if(child+1u<N && before(queue[child+1u], queue[child]))
+            child++;
+        if(!before(queue[child], temp))
+            break;
+        queue[index].swap(queue[child]);
+        queue[index]->heapIndex = index;
+        index = child;
+    }
+
+    queue[index].swap(temp);
+    queue[index]->heapIndex = index;
+}
+
 // call with mutex held
 void Timer::addElement(TimerCallbackPtr const & timerCallback)
 {
     assert(!timerCallback->onList);
 
-    queue_t temp;
-    temp.push_back(timerCallback);
-
     timerCallback->onList = true;
+    timerCallback->sequence = nextSequence++;
+
+    queue.push_back(timerCallback);
+    siftUp(queue.size()-1u);
+}
 
-    // merge sorted lists.
-    // for us effectively insertion sort.
-    queue.merge(temp, TimerCallback::IncreasingTime());
+// call with mutex held
+void Timer::removeElement(size_t index)
+{
+    assert(index<queue.size());
+
+    queue[index]->onList = false;
+
+    const size_t last = queue.size()-1u;
+    if(index!=last) {
+        queue[index].swap(queue[last]);
+        queue.pop_back();
+        // the moved element may belong either above or below
+        TimerCallback *moved = queue[index].get();
+        siftUp(index);
+        if(moved->heapIndex==index)
+            siftDown(index);
+    } else {
+        queue.pop_back();
+    }
 }
 
 
 bool Timer::cancel(TimerCallbackPtr const &timerCallback)
 {
     Lock xx(mutex);
+    if(timerCallback->rerun) {
+        // expired while running, and not yet re-dispatched.
+        // also don't re-schedule on completion
+        timerCallback->rerun = false;
+        timerCallback->period = 0u;
+        return true;
+    }
+    if(!timerCallback->onList && serialize && timerCallback->running && timerCallback->period) {
+        // running on a worker.  don't re-schedule on completion
+        timerCallback->period = 0u;
+        return true;
+    }
     if(!timerCallback->onList) return false;
     if(!alive) {
         timerCallback->onList = false;
         return true;
     }
-    for(queue_t::iterator it(queue.begin()), end(queue.end()); it != end; ++it)
-    {
-        TimerCallbackPtr& cur = *it;
-        if(cur.get() == timerCallback.get()) {
-            cur->onList = false;
-            queue.erase(it); // invalidates cur and it
-            return true;
-        }
-    }
-    throw std::logic_error("Timer::cancel() onList==true, but not found");
+    size_t index = timerCallback->heapIndex;
+    if(index>=queue.size() || queue[index].get()!=timerCallback.get())
+        throw std::logic_error("Timer::cancel() onList==true, but not found");
+    removeElement(index);
+    return true;
 }
 
 bool Timer::isScheduled(TimerCallbackPtr const &timerCallback) const
 {
     Lock xx(mutex);
-    return timerCallback->onList;
+    return timerCallback->onList || timerCallback->rerun;
+}
+
+TimerLateness Timer::getLateness(TimerCallbackPtr const &timerCallback) const
+{
+    Lock xx(mutex);
+    return timerCallback->lateness;
+}
+
+// call with mutex held.  Hand an expired callback to the workers
+void Timer::dispatch(TimerCallbackPtr const &timerCallback)
+{
+    if(serialize && timerCallback->running) {
+        // run again when the current call completes
+        timerCallback->rerun = true;
+        return;
+    }
+
+    if(!serialize && timerCallback->period && timerCallback->running>=workers.size()) {
+        // as many calls are queued or running as there are workers.
+        // skip this period, so that ready doesn't grow without bound
+        timerCallback->lateness.missed++;
+        lateness.missed++;
+        reschedule(timerCallback);
+        return;
+    }
+
+    timerCallback->running++;
+    ready.push_back(Ready());
+    ready.back().callback = timerCallback;
+    ready.back().due = timerCallback->timeToRun;
+    readyWork.signal();
+
+    if(!serialize && timerCallback->period)
+        reschedule(timerCallback);
+}
+
+// call with mutex held.  After callback() returns
+void Timer::completed(TimerCallbackPtr const &timerCallback, uint64 due, uint64 start)
+{
+    // lateness histogram bin
+    const uint64 late = start>due ? start-due : 0u;
+    size_t bin = 0u;
+    for(uint64 limit = 10000u; bin+1u<TimerLateness::NBins && late>=limit; limit *= 10u)
+        bin++;
+
+    TimerLateness* stats[2] = {&timerCallback->lateness, &lateness};
+    for(size_t i=0; i<2u; i++) {
+        TimerLateness& L = *stats[i];
+        L.count++;
+        L.total += toSec(late);
+        if(toSec(late) > L.max)
+            L.max = toSec(late);
+        L.histogram[bin]++;
+    }
+
+    if(workers.empty())
+        return;
+
+    timerCallback->running--;
+
+    if(!serialize || !alive) {
+        timerCallback->rerun = false;
+
+    } else if(timerCallback->rerun) {
+        timerCallback->rerun = false;
+        dispatch(timerCallback);
+
+    } else if(timerCallback->period && !timerCallback->onList) {
+        reschedule(timerCallback);
+        if(waiting && queue.front()==timerCallback)
+            waitForWork.signal();
+    }
+}
+
+// call with mutex held.
+// Periodic callbacks expire at multiples of their period from the first expiration.
+void Timer::reschedule(TimerCallbackPtr const &timerCallback)
+{
+    TimerCallback& cb = *timerCallback;
+    cb.timeToRun = addNS(cb.timeToRun, cb.period);
+
+    if(coalesce) {
+        const uint64 now(monotonicNow());
+        if(cb.timeToRun <= now) {
+            // skip to the next period which has not expired
+            uint64 skip = (now - cb.timeToRun)/cb.period + 1u;
+            cb.timeToRun = addNS(cb.timeToRun, skip*cb.period);
+            cb.lateness.missed += skip;
+            lateness.missed += skip;
+        }
+    }
+
+    addElement(timerCallback);
+}
+
+void Timer::work()
+{
+    Guard G(mutex);
+
+    while(alive) {
+        if(ready.empty()) {
+            UnGuard U(G);
+            readyWork.wait();
+            continue;
+        }
+
+        Ready job(ready.front());
+        ready.pop_front();
+        if(!ready.empty())
+            readyWork.signal(); // wake another worker
+
+        uint64 start;
+        {
+            UnGuard U(G);
+
+            start = monotonicNow();
+            job.callback->callback();
+        }
+
+        completed(job.callback, job.due, start);
+    }
+
+    // wake the next worker to exit
+    readyWork.signal();
 }
 
 
@@ -88,7 +391,9 @@ void Timer::run()
 {
     epicsGuard<epicsMutex> G(mutex);
 
-    epicsTime now(epicsTime::getCurrent());
+    uint64 now(monotonicNow());
+    // jobs have run since 'now' was updated
+    bool stale = false;
 
     while(alive) {
         double waitfor;
@@ -99,36 +404,49 @@ void Timer::run()
             epicsGuardRelease<epicsMutex> U(G);
 
             waitForWork.wait();
-            now = epicsTime::getCurrent();
+            now = monotonicNow();
+            stale = false;
 
-        } else if((waitfor = queue.front()->timeToRun - now) <= 0) {
+        } else if((waitfor = diffSec(queue.front()->timeToRun, now)) <= 0) {
             // execute first expired job
 
-            TimerCallbackPtr work;
-            work.swap(queue.front());
-            work->onList = false;
-            queue.pop_front();
+            TimerCallbackPtr work(queue.front());
+            removeElement(0u);
+            stale = true;
 
+            if(!workers.empty()) {
+                dispatch(work);
+                continue;
+            }
+
+            uint64 due(work->timeToRun), start;
             {
                 epicsGuardRelease<epicsMutex> U(G);
 
+                start = monotonicNow();
                 work->callback();
             }
 
-            if(work->period > 0.0 && alive) {
-                work->timeToRun += work->period;
-                addElement(work);
-            }
+            completed(work, due, start);
+
+            if(work->period && alive)
+                reschedule(work);
 
             // don't update 'now' until all expired jobs run
 
+        } else if(stale) {
+            // time has passed while running jobs.  re-check before waiting
+            now = monotonicNow();
+            stale = false;
+
         } else {
             waiting = true;
             // wait for first un-expired
             epicsGuardRelease<epicsMutex> U(G);
 
             waitForWork.wait(waitfor);
-            now = epicsTime::getCurrent();
+            now = monotonicNow();
+            stale = false;
         }
         waiting = false;
     }
@@ -148,11 +466,30 @@ void Timer::close() {
     waitForWork.signal();
     thread.exitWait();
 
+    // workers finish any callback in progress
+    readyWork.signal();
+    for(size_t i=0, N=workers.size(); i<N; i++)
+        workers[i]->exitWait();
+
     queue_t temp;
-    temp.swap(queue);
+    {
+        Lock xx(mutex);
+        temp.swap(queue);
+        // expired, but not yet run
+        for(size_t i=0, N=ready.size(); i<N; i++)
+            temp.push_back(ready[i].callback);
+        ready.clear();
+    }
+
+    // without serialize(), a callback may be both queued and ready
+    std::sort(temp.begin(), temp.end());
+    temp.erase(std::unique(temp.begin(), temp.end()), temp.end());
+
+    // notify in order of expiration
+    std::sort(temp.begin(), temp.end(), TimerCallback::IncreasingTime());
 
-    for(;!temp.empty(); temp.pop_front()) {
-        TimerCallbackPtr& head = temp.front();
+    for(size_t i=0, N=temp.size(); i<N; i++) {
+        TimerCallbackPtr& head = temp[i];
         head->onList = false;
         head->timerStopped();
     }
@@ -170,7 +507,7 @@ void Timer::schedulePeriodic(
     double delay,
     double period)
 {
-    epicsTime now(epicsTime::getCurrent());
+    uint64 now(monotonicNow());
 
     bool wakeup;
     {
@@ -185,8 +522,8 @@ void Timer::schedulePeriodic(
             return;
         }
 
-        timerCallback->timeToRun = now + delay;
-        timerCallback->period = period;
+        timerCallback->timeToRun = addNS(now, toNS(delay));
+        timerCallback->period = toNS(period);
 
         addElement(timerCallback);
         wakeup = waiting && queue.front()==timerCallback;
@@ -198,12 +535,36 @@ void Timer::dump(std::ostream& o) const
 {
     Lock xx(mutex);
     if(!alive) return;
-    epicsTime now(epicsTime::getCurrent());
+    uint64 now(monotonicNow());
 
-    for(queue_t::const_iterator it(queue.begin()), end(queue.end()); it!=end; ++it) {
+    // heap order is not expiration order
+    queue_t sorted(queue);
+    std::sort(sorted.begin(), sorted.end(), TimerCallback::IncreasingTime());
+
+    for(queue_t::const_iterator it(sorted.begin()), end(sorted.end()); it!=end; ++it) {
         const TimerCallbackPtr& nodeToCall = *it;
-        o << "timeToRun " << (nodeToCall->timeToRun - now)
-          << " period " << nodeToCall->period << "\n";
+        const TimerLateness& L = nodeToCall->lateness;
+        o << "timeToRun " << diffSec(nodeToCall->timeToRun, now)
+          << " period " << toSec(nodeToCall->period);
+        if(L.count)
+            o << " late mean " << L.mean() << " max " << L.max;
+        if(L.missed)
+            o << " missed " << L.missed;
+        o << "\n";
+    }
+
+    static const char *limits[TimerLateness::NBins-1] = {"10us", "100us", "1ms", "10ms", "100ms", "1s"};
+
+    o << "lateness count " << lateness.count
+      << " mean " << lateness.mean()
+      << " max " << lateness.max
+      << " missed " << lateness.missed << "\n";
+    for(size_t i=0; i<TimerLateness::NBins; i++) {
+        if(i+1u<TimerLateness::NBins)
+            o << "  <  ";
+        else
+            o << "  >= ";
+        o << limits[i+1u<TimerLateness::NBins ? i : i-1u] << " : " << lateness.histogram[i] << "\n";
     }
 }
 
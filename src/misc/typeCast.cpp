@@ -18,23 +18,33 @@ using epics::pvData::ScalarType;
 using epics::pvData::pvString;
 using std::string;
 
+#if defined(__GNUC__) || defined(_MSC_VER)
+#  define RESTRICT __restrict
+#else
+#  define RESTRICT
+#endif
+
 namespace {
 
+// elements converted by each iteration of the vectorized loop
+#define VBLOCK 16u
+
 static void noconvert()
 {
     throw std::runtime_error("castUnsafeV: Conversion not supported");
 }
 
+// Conversions to or from std::string may throw.
+// Report the index of the failing element.
 template<typename TO, typename FROM>
-static void castVTyped(size_t count, void *draw, const void *sraw)
+static void castVChecked(size_t count, void *draw, const void *sraw)
 {
     TO *dest=(TO*)draw;
     const FROM *src=(FROM*)sraw;
-
-    //std::transform(src, src+count, dest, castUnsafe<TO,FROM>);
+    size_t i=0;
 
     try {
-        for(size_t i=0; i<count; i++) {
+        for(; i<count; i++) {
             dest[i] = castUnsafe<TO,FROM>(src[i]);
         }
     } catch (std::exception& ex) {
@@ -42,7 +52,7 @@ static void castVTyped(size_t count, void *draw, const void *sraw)
         if (count > 1)
         {
             std::ostringstream os;
-            os << "failed to parse element at index " << (src - (FROM*)sraw);
+            os << "failed to parse element at index " << i;
             os << ": " << ex.what();
             throw std::runtime_error(os.str());
         }
@@ -51,6 +61,43 @@ static void castVTyped(size_t count, void *draw, const void *sraw)
     }
 }
 
+// Numeric conversions can't throw.
+// Written so that the compiler can vectorize, even with the cautious
+// cost model of -O2.  Source and destination do not overlap, and the inner
+// loop has a fixed trip count.
+template<typename TO, typename FROM>
+struct castVTyped {
+    static void op(size_t count, void *dest, const void *src)
+    {
+        convert(count, (TO*)dest, (const FROM*)src);
+    }
+
+    static void convert(size_t count, TO * RESTRICT dest, const FROM * RESTRICT src)
+    {
+        size_t i=0;
+
+        for(; i+VBLOCK<=count; i+=VBLOCK) {
+            for(size_t j=0; j<VBLOCK; j++)
+                dest[i+j] = epics::pvData::detail::cast_helper<TO,FROM>::op(src[i+j]);
+        }
+        for(; i<count; i++) {
+            dest[i] = epics::pvData::detail::cast_helper<TO,FROM>::op(src[i]);
+        }
+    }
+};
+
+template<typename TO>
+struct castVTyped<TO, std::string> {
+    static void op(size_t count, void *draw, const void *sraw)
+    { castVChecked<TO, std::string>(count, draw, sraw); }
+};
+
+template<typename FROM>
+struct castVTyped<std::string, FROM> {
+    static void op(size_t count, void *draw, const void *sraw)
+    { castVChecked<std::string, FROM>(count, draw, sraw); }
+};
+
 template<typename T>
 static void copyV(size_t count, void *draw, const void *sraw)
 {
@@ -72,7 +119,7 @@ namespace epics { namespace pvData {
 void castUnsafeV(size_t count, ScalarType to, void *dest, ScalarType from, const void *src)
 {
 #define COPYMEM(N) copyMem<N>(count, dest, src)
-#define CAST(TO, FROM) castVTyped<TO, FROM>(count, dest, src)
+#define CAST(TO, FROM) castVTyped<TO, FROM>::op(count, dest, src)
 
     switch(to) {
     case pvBoolean:
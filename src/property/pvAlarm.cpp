@@ -9,11 +9,14 @@
 #include <string>
 #include <stdexcept>
 
+#include <epicsThread.h>
+
 #define epicsExportSharedSymbols
 #include <pv/pvType.h>
 #include <pv/pvIntrospect.h>
 #include <pv/pvData.h>
 #include <pv/pvAlarm.h>
+#include <pv/standardField.h>
 
 using std::tr1::static_pointer_cast;
 using std::string;
@@ -23,10 +26,46 @@ namespace epics { namespace pvData {
 string PVAlarm::noAlarmFound("No alarm structure found");
 string PVAlarm::notAttached("Not attached to an alarm structure");
 
+namespace {
+// pre-resolved members of the standard alarm structure
+struct StandardAlarm {
+    StructureConstPtr type;
+    FieldAccessor<PVInt> severity;
+    FieldAccessor<PVInt> status;
+    FieldAccessor<PVString> message;
+    StandardAlarm()
+        :type(getStandardField()->alarm())
+        ,severity(type, "severity")
+        ,status(type, "status")
+        ,message(type, "message")
+    {}
+};
+
+StandardAlarm* standardAlarm;
+epicsThreadOnceId standardAlarmOnce = EPICS_THREAD_ONCE_INIT;
+
+void standardAlarmInit(void*)
+{
+    standardAlarm = new StandardAlarm;
+}
+}
+
 bool PVAlarm::attach(PVFieldPtr const & pvField)
 {
     if(pvField->getField()->getType()!=structure) return false;
     PVStructurePtr pvStructure = static_pointer_cast<PVStructure>(pvField);
+
+    epicsThreadOnce(&standardAlarmOnce, &standardAlarmInit, 0);
+    const StandardAlarm& known(*standardAlarm);
+
+    if(pvStructure->getStructure()==known.type) {
+        // common case.  skip lookup by name
+        pvSeverity = static_pointer_cast<PVInt>(known.severity(*pvStructure).shared_from_this());
+        pvStatus = static_pointer_cast<PVInt>(known.status(*pvStructure).shared_from_this());
+        pvMessage = static_pointer_cast<PVString>(known.message(*pvStructure).shared_from_this());
+        return true;
+    }
+
     pvSeverity = pvStructure->getSubField<PVInt>("severity");
     if(pvSeverity.get()==NULL) return false;
     pvStatus = pvStructure->getSubField<PVInt>("status");
@@ -9,11 +9,14 @@
 #include <string>
 #include <stdexcept>
 
+#include <epicsThread.h>
+
 #define epicsExportSharedSymbols
 #include <pv/pvType.h>
 #include <pv/timeStamp.h>
 #include <pv/pvData.h>
 #include <pv/pvTimeStamp.h>
+#include <pv/standardField.h>
 
 using std::tr1::static_pointer_cast;
 using std::string;
@@ -23,12 +26,47 @@ namespace epics { namespace pvData {
 string PVTimeStamp::noTimeStamp("No timeStamp structure found");
 string PVTimeStamp::notAttached("Not attached to a timeStamp structure");
 
+namespace {
+// pre-resolved members of the standard timeStamp structure
+struct StandardTimeStamp {
+    StructureConstPtr type;
+    FieldAccessor<PVLong> secs;
+    FieldAccessor<PVInt> nano;
+    FieldAccessor<PVInt> userTag;
+    StandardTimeStamp()
+        :type(getStandardField()->timeStamp())
+        ,secs(type, "secondsPastEpoch")
+        ,nano(type, "nanoseconds")
+        ,userTag(type, "userTag")
+    {}
+};
+
+StandardTimeStamp* standardTimeStamp;
+epicsThreadOnceId standardTimeStampOnce = EPICS_THREAD_ONCE_INIT;
+
+void standardTimeStampInit(void*)
+{
+    standardTimeStamp = new StandardTimeStamp;
+}
+}
+
 bool PVTimeStamp::attach(PVFieldPtr const & pvField)
 {
     if(pvField->getField()->getType()!=structure) return false;
     PVStructurePtr xxx = static_pointer_cast<PVStructure>(pvField);
     PVStructure* pvStructure = xxx.get();
+
+    epicsThreadOnce(&standardTimeStampOnce, &standardTimeStampInit, 0);
+    const StandardTimeStamp& known(*standardTimeStamp);
+
     while(true) {
+        if(pvStructure->getStructure()==known.type) {
+            // common case.  skip lookup by name
+            pvSecs = static_pointer_cast<PVLong>(known.secs(*pvStructure).shared_from_this());
+            pvNano = static_pointer_cast<PVInt>(known.nano(*pvStructure).shared_from_this());
+            pvUserTag = static_pointer_cast<PVInt>(known.userTag(*pvStructure).shared_from_this());
+            return true;
+        }
         PVLongPtr pvLong = pvStructure->getSubField<PVLong>("secondsPastEpoch");
         if(pvLong) {
             pvSecs = pvLong;
@@ -191,6 +191,11 @@ public:
      * This is equal to nextFieldOffset - fieldOffset.
      */
     std::size_t getNumberFields() const;
+    /**
+     * Number of bytes which serialize() will write.
+     * @version Added after 8.0.5
+     */
+    virtual std::size_t getSerializedSize() const;
     /**
      * Is the field immutable, i.e. does it not allow changes.
      * @return (false,true) if it (is not, is) immutable.
@@ -439,6 +444,7 @@ public:
         SerializableControl *pflusher) const OVERRIDE;
     virtual void deserialize(ByteBuffer *pbuffer,
         DeserializableControl *pflusher) OVERRIDE FINAL;
+    virtual std::size_t getSerializedSize() const OVERRIDE FINAL;
 
 protected:
     explicit PVScalarValue(ScalarConstPtr const & scalar)
@@ -737,24 +743,24 @@ public:
 
     /**
      * Get the subfield with the specified offset.
-     * @param a A sub-field name or index
+     * @param a A sub-field name, index, or FieldPath
      * @return Pointer to the field or NULL if field does not exist.
      */
     template<typename A>
-    FORCE_INLINE std::tr1::shared_ptr<PVField> getSubField(A a)
+    FORCE_INLINE std::tr1::shared_ptr<PVField> getSubField(const A& a)
     {
         return getSubFieldImpl(a, false);
     }
 
     template<typename A>
-    FORCE_INLINE std::tr1::shared_ptr<const PVField> getSubField(A a) const
+    FORCE_INLINE std::tr1::shared_ptr<const PVField> getSubField(const A& a) const
     {
         return getSubFieldImpl(a, false);
     }
 
     /**
      * Get a subfield with the specified name.
-     * @param a A sub-field name or index
+     * @param a A sub-field name, index, or FieldPath
      * @returns A pointer to the sub-field or null if field does not exist or has a different type
      * @code
      *   PVIntPtr ptr = pvStruct->getSubField<PVInt>("substruct.leaffield");
@@ -763,14 +769,14 @@ public:
      *  A field name is a '.' delimited list of child field names (no whitespace allowed)
      */
     template<typename PVD, typename A>
-    inline std::tr1::shared_ptr<PVD> getSubField(A a)
+    inline std::tr1::shared_ptr<PVD> getSubField(const A& a)
     {
         STATIC_ASSERT(PVD::isPVField); // only allow cast from PVField sub-class
         return std::tr1::dynamic_pointer_cast<PVD>(getSubFieldImpl(a, false));
     }
 
     template<typename PVD, typename A>
-    inline std::tr1::shared_ptr<const PVD> getSubField(A a) const
+    inline std::tr1::shared_ptr<const PVD> getSubField(const A& a) const
     {
         STATIC_ASSERT(PVD::isPVField); // only allow cast from PVField sub-class
         return std::tr1::dynamic_pointer_cast<const PVD>(getSubFieldImpl(a, false));
@@ -778,18 +784,18 @@ public:
 
     /**
      * Get the subfield with the specified offset.
-     * @param a A sub-field name or index
+     * @param a A sub-field name, index, or FieldPath
      * @throws std::runtime_error if the requested sub-field doesn't exist, or has a different type
      * @return Pointer to the field
      */
     template<typename A>
-    FORCE_INLINE std::tr1::shared_ptr<PVField> getSubFieldT(A a)
+    FORCE_INLINE std::tr1::shared_ptr<PVField> getSubFieldT(const A& a)
     {
         return getSubFieldImpl(a, true);
     }
 
     template<typename A>
-    FORCE_INLINE std::tr1::shared_ptr<const PVField> getSubFieldT(A a) const
+    FORCE_INLINE std::tr1::shared_ptr<const PVField> getSubFieldT(const A& a) const
     {
         return getSubFieldImpl(a, true);
     }
@@ -800,10 +806,13 @@ private:
     static FORCE_INLINE void throwBadFieldType(const std::string& name) {
         throwBadFieldType(name.c_str());
     }
+    static FORCE_INLINE void throwBadFieldType(const FieldPath& path) {
+        throwBadFieldType(path.getFieldOffset());
+    }
 public:
 
     template<typename PVD, typename A>
-    inline std::tr1::shared_ptr<PVD> getSubFieldT(A a)
+    inline std::tr1::shared_ptr<PVD> getSubFieldT(const A& a)
     {
         STATIC_ASSERT(PVD::isPVField); // only allow cast from PVField sub-class
         std::tr1::shared_ptr<PVD> ret(std::tr1::dynamic_pointer_cast<PVD>(getSubFieldImpl(a, true)));
@@ -813,7 +822,7 @@ public:
     }
 
     template<typename PVD, typename A>
-    inline std::tr1::shared_ptr<const PVD> getSubFieldT(A a) const
+    inline std::tr1::shared_ptr<const PVD> getSubFieldT(const A& a) const
     {
         STATIC_ASSERT(PVD::isPVField); // only allow cast from PVField sub-class
         std::tr1::shared_ptr<const PVD> ret(std::tr1::dynamic_pointer_cast<const PVD>(getSubFieldImpl(a, true)));
@@ -844,6 +853,14 @@ public:
     */
     virtual void serialize(ByteBuffer *pbuffer,
         SerializableControl *pflusher,BitSet *pbitSet) const OVERRIDE FINAL;
+    virtual std::size_t getSerializedSize() const OVERRIDE FINAL;
+    /**
+     * Number of bytes which serialize(ByteBuffer*, SerializableControl*, BitSet*) will write.
+     * The BitSet itself is not included.
+     * @param changed A bitset the specifies which fields to serialize.
+     * @version Added after 8.0.5
+     */
+    std::size_t getSerializedSize(const BitSet& changed) const;
     /**
      * Deserialize
      * @param pbuffer The byte buffer.
@@ -919,14 +936,172 @@ private:
     }
     PVFieldPtr getSubFieldImpl(const char *name, bool throws) const;
     PVFieldPtr getSubFieldImpl(std::size_t fieldOffset, bool throws) const;
+    PVFieldPtr getSubFieldImpl(const FieldPath& path, bool throws) const;
+    // lookup without reference counting.  NULL if path was resolved against a different Structure
+    inline PVField* getSubFieldRaw(const FieldPath& path) const;
 
     PVFieldPtrArray pvFields;
     StructureConstPtr structurePtr;
     std::string extendsStructureName;
     friend class PVDataCreate;
+    template<typename PVD> friend class FieldAccessor;
     EPICS_NOT_COPYABLE(PVStructure)
 };
 
+PVField* PVStructure::getSubFieldRaw(const FieldPath& path) const
+{
+    if(path.getStructure().get()!=structurePtr.get())
+        return NULL;
+
+    const std::vector<uint32>& indices = path.getIndices();
+    const PVStructure *parent = this;
+
+    // types match, so every intermediate is a PVStructure
+    for(size_t i=0, N=indices.size()-1; i<N; i++)
+        parent = static_cast<const PVStructure*>(parent->pvFields[indices[i]].get());
+
+    return parent->pvFields[indices.back()].get();
+}
+
+namespace detail {
+// Test if the PVField which Field::build() would create is an instance of PVD,
+// without creating it.
+template<typename PVD>
+struct field_builds {
+    // any other PVField sub-class
+    static bool op(const Field& field) {
+        PVFieldPtr temp(field.build());
+        return !!dynamic_cast<PVD*>(temp.get());
+    }
+};
+template<>
+struct field_builds<PVField> {
+    static bool op(const Field&) { return true; }
+};
+template<>
+struct field_builds<PVScalar> {
+    static bool op(const Field& field) { return field.getType()==scalar; }
+};
+template<typename T>
+struct field_builds<PVScalarValue<T> > {
+    static bool op(const Field& field) {
+        return field.getType()==scalar
+                && static_cast<const Scalar&>(field).getScalarType()==PVScalarValue<T>::typeCode;
+    }
+};
+template<>
+struct field_builds<PVString> : public field_builds<PVScalarValue<std::string> > {};
+template<>
+struct field_builds<PVArray> {
+    static bool op(const Field& field) {
+        Type type = field.getType();
+        return type==scalarArray || type==structureArray || type==unionArray;
+    }
+};
+template<>
+struct field_builds<PVScalarArray> {
+    static bool op(const Field& field) { return field.getType()==scalarArray; }
+};
+template<typename T>
+struct field_builds<PVValueArray<T> > {
+    static bool op(const Field& field) {
+        return field.getType()==scalarArray
+                && static_cast<const ScalarArray&>(field).getElementType()==PVValueArray<T>::typeCode;
+    }
+};
+template<>
+struct field_builds<PVValueArray<PVStructurePtr> > {
+    static bool op(const Field& field) { return field.getType()==structureArray; }
+};
+template<>
+struct field_builds<PVValueArray<PVUnionPtr> > {
+    static bool op(const Field& field) { return field.getType()==unionArray; }
+};
+template<>
+struct field_builds<PVStructure> {
+    static bool op(const Field& field) { return field.getType()==structure; }
+};
+template<>
+struct field_builds<PVUnion> {
+    static bool op(const Field& field) { return field.getType()==union_; }
+};
+} // namespace detail
+
+/** @brief Typed access to a sub-field through a pre-resolved FieldPath
+ *
+ * The path is resolved, and the type of the sub-field checked, once on construction.
+ * Access to the sub-field of any PVStructure of the same Structure
+ * then returns a plain pointer or reference, with neither dynamic_cast
+ * nor reference counting.
+ *
+ * The returned pointer or reference is valid only as long as the
+ * PVStructure from which it was obtained.
+ *
+ * @code
+ *   FieldAccessor<PVDouble> value(type, "value");
+ *   FieldAccessor<PVInt> sevr(type, "alarm.severity");
+ *   for(...) {
+ *       double val = value(*pvStruct).get();
+ *       sevr(*pvStruct).put(0);
+ *   }
+ * @endcode
+ *
+ * @version Added after 8.0.5
+ */
+template<typename PVD>
+class FieldAccessor {
+    FieldPath path;
+public:
+    typedef PVD pv_type;
+
+    //! An empty accessor, which refers to nothing
+    FieldAccessor() {}
+    /** Resolve the given path and check its type
+     * @param top The Structure against which the path is resolved
+     * @param fieldName A '.' separated list of sub-field names
+     * @throws std::runtime_error if no such sub-field exists, or has a type other than PVD.
+     */
+    FieldAccessor(const StructureConstPtr& top, const std::string& fieldName)
+        :path(top, fieldName)
+    {
+        STATIC_ASSERT(PVD::isPVField); // only allow cast from PVField sub-class
+        if(!detail::field_builds<PVD>::op(*path.getField()))
+            throw std::runtime_error("Failed to get field: "+fieldName+" (Field has wrong type)");
+    }
+
+    //! false for a default constructed FieldAccessor
+    bool valid() const { return path.valid(); }
+    const FieldPath& getPath() const { return path; }
+    //! Field offset of the sub-field, as PVField::getFieldOffset()
+    std::size_t getFieldOffset() const { return path.getFieldOffset(); }
+
+    //! @returns NULL if pv is not an instance of the Structure this accessor was built from
+    PVD* get(PVStructure& pv) const {
+        return static_cast<PVD*>(pv.getSubFieldRaw(path));
+    }
+    const PVD* get(const PVStructure& pv) const {
+        return static_cast<const PVD*>(pv.getSubFieldRaw(path));
+    }
+
+    //! @throws std::runtime_error if pv is not an instance of the Structure this accessor was built from
+    PVD& operator()(PVStructure& pv) const {
+        PVD *ret = get(pv);
+        if(!ret)
+            throwWrongType();
+        return *ret;
+    }
+    const PVD& operator()(const PVStructure& pv) const {
+        const PVD *ret = get(pv);
+        if(!ret)
+            throwWrongType();
+        return *ret;
+    }
+private:
+    static void throwWrongType() {
+        throw std::runtime_error("Failed to get field: (FieldAccessor resolved against a different Structure)");
+    }
+};
+
 epicsShareFunc
 std::ostream& operator<<(std::ostream& strm, const PVStructure::Formatter& format);
 
@@ -1064,6 +1239,7 @@ public:
      */
     virtual void deserialize(
         ByteBuffer *pbuffer,DeserializableControl *pflusher) OVERRIDE FINAL;
+    virtual std::size_t getSerializedSize() const OVERRIDE FINAL;
     /**
      * Constructor
      * @param punion The introspection interface.
@@ -1215,6 +1391,7 @@ public:
     virtual void deserialize(ByteBuffer *pbuffer,DeserializableControl *pflusher) OVERRIDE FINAL;
     virtual void serialize(ByteBuffer *pbuffer,
                            SerializableControl *pflusher, size_t offset, size_t count) const OVERRIDE FINAL;
+    virtual std::size_t getSerializedSize() const OVERRIDE FINAL;
 
 protected:
     virtual void _getAsVoid(epics::pvData::shared_vector<const void>& out) const OVERRIDE FINAL;
@@ -1222,6 +1399,9 @@ protected:
 
     explicit PVValueArray(ScalarArrayConstPtr const & scalar);
     const_svector value;
+    // A second reference to storage borrowed from a receive buffer by deserialize().
+    // So that value (or the result of reuse()) is never unique(), and the buffer is never modified.
+    const_svector borrowed;
     friend class PVDataCreate;
     EPICS_NOT_COPYABLE(PVValueArray)
 };
@@ -1308,6 +1488,7 @@ public:
         DeserializableControl *pflusher) OVERRIDE FINAL;
     virtual void serialize(ByteBuffer *pbuffer,
         SerializableControl *pflusher, std::size_t offset, std::size_t count) const OVERRIDE FINAL;
+    virtual std::size_t getSerializedSize() const OVERRIDE FINAL;
 
     virtual std::ostream& dumpValue(std::ostream& o) const OVERRIDE FINAL;
     virtual std::ostream& dumpValue(std::ostream& o, std::size_t index) const OVERRIDE FINAL;
@@ -1407,6 +1588,7 @@ public:
         DeserializableControl *pflusher) OVERRIDE FINAL;
     virtual void serialize(ByteBuffer *pbuffer,
         SerializableControl *pflusher, std::size_t offset, std::size_t count) const OVERRIDE FINAL;
+    virtual std::size_t getSerializedSize() const OVERRIDE FINAL;
 
     virtual std::ostream& dumpValue(std::ostream& o) const OVERRIDE FINAL;
     virtual std::ostream& dumpValue(std::ostream& o, std::size_t index) const OVERRIDE FINAL;
@@ -1543,6 +1725,21 @@ public:
       * @return The PVStructure implementation.
       */
     PVStructurePtr createPVStructure(PVStructurePtr const & structToClone);
+    /**
+     * Create implementation for PVStructure with flat storage.
+     *
+     * The PVStructure, and all of its scalar and (sub-)structure fields,
+     * are placed in a single contiguous allocation.
+     * This allocation is released when the last of these is destroyed.
+     * Array and union fields, and their contents, are allocated separately as usual.
+     *
+     * Otherwise equivalent to createPVStructure(StructureConstPtr const &)
+     *
+     * @param structure The introspection interface.
+     * @return The PVStructure implementation
+     * @version Added after 8.0.5
+     */
+    PVStructurePtr createPVStructureFlat(StructureConstPtr const & structure);
 
     /**
      * Create implementation for PVUnion.
@@ -1636,6 +1833,8 @@ public:
 private:
    PVDataCreate();
    FieldCreatePtr fieldCreate;
+   struct Arena;
+   PVFieldPtr createPVFieldFlat(FieldConstPtr const & field, Arena& arena);
    EPICS_NOT_COPYABLE(PVDataCreate)
 };
 
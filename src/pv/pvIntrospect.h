@@ -13,6 +13,8 @@
 #include <stdexcept>
 #include <iostream>
 #include <map>
+#include <vector>
+#include <utility>
 
 #include <epicsAssert.h>
 
@@ -351,6 +353,13 @@ public:
      */
     virtual std::ostream& dump(std::ostream& o) const = 0;
 
+    /** Number of bytes which serialize() will write.
+     *
+     * Assumes that nested types are serialized in full (without cache).
+     * @version Added after 8.0.5
+     */
+    virtual std::size_t getSerializedSize() const;
+
    //! Allocate a new instance
    //! @version Added after 7.0.0
     std::tr1::shared_ptr<PVField> build() const;
@@ -403,6 +412,7 @@ public:
     virtual std::ostream& dump(std::ostream& o) const OVERRIDE FINAL;
 
     virtual void serialize(ByteBuffer *buffer, SerializableControl *control) const OVERRIDE;
+    virtual std::size_t getSerializedSize() const OVERRIDE;
     virtual void deserialize(ByteBuffer *buffer, DeserializableControl *control) OVERRIDE FINAL;
 
     //! Allocate a new instance
@@ -436,6 +446,7 @@ public:
     virtual std::string getID() const OVERRIDE FINAL;
 
     virtual void serialize(ByteBuffer *buffer, SerializableControl *control) const OVERRIDE FINAL;
+    virtual std::size_t getSerializedSize() const OVERRIDE FINAL;
 
     std::size_t getMaximumLength() const;
 
@@ -512,6 +523,7 @@ public:
     virtual std::ostream& dump(std::ostream& o) const OVERRIDE FINAL;
 
     virtual void serialize(ByteBuffer *buffer, SerializableControl *control) const OVERRIDE;
+    virtual std::size_t getSerializedSize() const OVERRIDE;
     virtual void deserialize(ByteBuffer *buffer, DeserializableControl *control) OVERRIDE FINAL;
 
     //! Allocate a new instance
@@ -552,6 +564,7 @@ public:
     virtual std::string getID() const OVERRIDE FINAL;
 
     virtual void serialize(ByteBuffer *buffer, SerializableControl *control) const OVERRIDE FINAL;
+    virtual std::size_t getSerializedSize() const OVERRIDE FINAL;
 
     virtual ~BoundedScalarArray();
 private:
@@ -584,6 +597,7 @@ public:
     virtual std::string getID() const OVERRIDE FINAL;
 
     virtual void serialize(ByteBuffer *buffer, SerializableControl *control) const OVERRIDE FINAL;
+    virtual std::size_t getSerializedSize() const OVERRIDE FINAL;
 
     virtual ~FixedScalarArray();
 private:
@@ -617,6 +631,7 @@ public:
     virtual std::ostream& dump(std::ostream& o) const OVERRIDE FINAL;
 
     virtual void serialize(ByteBuffer *buffer, SerializableControl *control) const OVERRIDE FINAL;
+    virtual std::size_t getSerializedSize() const OVERRIDE FINAL;
     virtual void deserialize(ByteBuffer *buffer, DeserializableControl *control) OVERRIDE FINAL;
 
     //! Allocate a new instance
@@ -662,6 +677,7 @@ public:
     virtual std::ostream& dump(std::ostream& o) const OVERRIDE FINAL;
 
     virtual void serialize(ByteBuffer *buffer, SerializableControl *control) const OVERRIDE FINAL;
+    virtual std::size_t getSerializedSize() const OVERRIDE FINAL;
     virtual void deserialize(ByteBuffer *buffer, DeserializableControl *control) OVERRIDE FINAL;
 
     //! Allocate a new instance
@@ -808,6 +824,14 @@ public:
      * This will be -1 if the field is not in the structure.
      */
     std::size_t getFieldIndex(std::string const &fieldName) const;
+    /**
+     * Get the field index for a field name which need not be nil terminated.
+     * @param fieldName Start of member field name. May not contain '.'
+     * @param len Length of field name.
+     * @return The field index, or (size_t)-1 if the field is not in the structure.
+     * @version Added after 8.0.5
+     */
+    std::size_t getFieldIndex(const char *fieldName, std::size_t len) const;
     /**
      * Get the fields in the structure.
      * @return The array of fields.
@@ -825,11 +849,24 @@ public:
      */
     const std::string& getFieldName(std::size_t fieldIndex) const {return fieldNames.at(fieldIndex);}
 
+    //! [begin, end) field offsets
+    typedef std::pair<uint32, uint32> range_t;
+    typedef std::vector<range_t> ranges_t;
+    /**
+     * Field offset ranges of this Structure and all nested Structures, in field offset order.
+     * Offsets are relative to this Structure, so the first entry is [0, N)
+     * where N is the total number of fields, as PVStructure::getNumberFields().
+     * Entries cover the Structure and all of its sub-fields.
+     * @version Added after 8.0.5
+     */
+    const ranges_t& getStructureRanges() const {return structureRanges;}
+
     virtual std::string getID() const OVERRIDE FINAL;
 
     virtual std::ostream& dump(std::ostream& o) const OVERRIDE FINAL;
 
     virtual void serialize(ByteBuffer *buffer, SerializableControl *control) const OVERRIDE FINAL;
+    virtual std::size_t getSerializedSize() const OVERRIDE FINAL;
     virtual void deserialize(ByteBuffer *buffer, DeserializableControl *control) OVERRIDE FINAL;
 
     //! Allocate a new instance
@@ -842,6 +879,10 @@ private:
     StringArray fieldNames;
     FieldConstPtrArray fields;
     std::string id;
+    // open addressed hash table of indices into fieldNames.
+    // size is a power of 2, empty slots are (uint32)-1
+    std::vector<uint32> nameIndex;
+    ranges_t structureRanges;
 
     FieldConstPtr getFieldImpl(const std::string& fieldName, bool throws) const;
     void dumpFields(std::ostream& o) const;
@@ -851,6 +892,51 @@ private:
     EPICS_NOT_COPYABLE(Structure)
 };
 
+/** @brief A field path resolved against a particular Structure.
+ *
+ * Resolves a '.' separated path once, and may then be used to
+ * find the same sub-field in any PVStructure with this Structure.
+ *
+ * @code
+ *   FieldPath sevr(type, "alarm.severity");
+ *   for(...) {
+ *       PVIntPtr S(pvStruct->getSubFieldT<PVInt>(sevr));
+ *       BitSet changed;
+ *       changed.set(sevr.getFieldOffset());
+ *   }
+ * @endcode
+ *
+ * @version Added after 8.0.5
+ */
+class epicsShareClass FieldPath {
+public:
+    //! An empty path, which refers to nothing.
+    FieldPath() :offset(0) {}
+    /** Resolve the given path
+     * @param top The Structure against which the path is resolved
+     * @param path A '.' separated list of sub-field names
+     * @throws std::runtime_error if no such sub-field exists.
+     */
+    FieldPath(const StructureConstPtr& top, const std::string& path);
+
+    //! false for a default constructed FieldPath
+    bool valid() const { return !!type; }
+    //! The Structure against which this path was resolved
+    const StructureConstPtr& getStructure() const { return type; }
+    //! The Field of the sub-field this path refers to
+    const FieldConstPtr& getField() const { return field; }
+    //! Field offset of the sub-field, as PVField::getFieldOffset() relative to the top structure
+    std::size_t getFieldOffset() const { return offset; }
+    //! Member index at each level from the top structure down
+    const std::vector<uint32>& getIndices() const { return indices; }
+
+private:
+    StructureConstPtr type;
+    FieldConstPtr field;
+    std::vector<uint32> indices;
+    std::size_t offset;
+};
+
 /**
  * @brief This class implements introspection object for a union.
  *
@@ -1026,6 +1112,7 @@ public:
     virtual std::ostream& dump(std::ostream& o) const OVERRIDE FINAL;
 
     virtual void serialize(ByteBuffer *buffer, SerializableControl *control) const OVERRIDE FINAL;
+    virtual std::size_t getSerializedSize() const OVERRIDE FINAL;
     virtual void deserialize(ByteBuffer *buffer, DeserializableControl *control) OVERRIDE FINAL;
 
     //! Allocate a new instance
@@ -1392,9 +1479,14 @@ private:
     UnionConstPtr variantUnion;
     UnionArrayConstPtr variantUnionArray;
 
-    mutable Mutex mutex;
+    // de-duplication cache, split by hash to reduce lock contention
     typedef std::multimap<unsigned int, Field*> cache_t;
-    mutable cache_t cache;
+    struct CacheShard {
+        Mutex mutex;
+        cache_t cache;
+    };
+    enum {numCacheShards = 64};
+    mutable CacheShard cacheShards[numCacheShards];
 
     struct Helper;
     friend class Field;
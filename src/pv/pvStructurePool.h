@@ -0,0 +1,83 @@
+/* pvStructurePool.h */
+/*
+ * Copyright information and license terms for this software can be
+ * found in the file LICENSE that is included with the distribution
+ */
+#ifndef PVSTRUCTUREPOOL_H
+#define PVSTRUCTUREPOOL_H
+
+#include <pv/pvIntrospect.h>
+#include <pv/pvData.h>
+
+#include <shareLib.h>
+
+namespace epics { namespace pvData {
+
+/** @brief Recycles PVStructure instances of a single Structure
+ *
+ * For users, such as monitor queues, which repeatedly allocate and
+ * release PVStructures of the same type.
+ *
+ * @code
+ *   PVStructurePool pool(type);
+ *   ...
+ *   PVStructurePtr update(pool.get()); // recycled instance if available
+ *   ...
+ *   update.reset(); // returned to the pool with the last reference
+ * @endcode
+ *
+ * An instance is returned to the pool when its last reference is released,
+ * unless the number of free instances is already at the high water mark,
+ * in which case it is destroyed.
+ * If reset is enabled (the default) then returned instances are first
+ * reset to the values of a newly created PVStructure.
+ *
+ * Instances which have been made immutable are not recycled.
+ * Post handlers must not be set on pooled instances.
+ * References to sub-fields (eg. from getSubField()) must not be kept
+ * after the last reference to the top level PVStructure is released,
+ * as the instance they refer to may then be reset and given out by get().
+ *
+ * The pool may be destroyed while instances are outstanding.
+ * These are then destroyed when released.
+ *
+ * @version Added after 8.0.5
+ */
+class epicsShareClass PVStructurePool {
+    EPICS_NOT_COPYABLE(PVStructurePool)
+public:
+    POINTER_DEFINITIONS(PVStructurePool);
+
+    /**
+     * @param type The Structure of all instances
+     * @param highWater Maximum number of free instances kept
+     * @param reset If true, returned instances are reset to default values
+     */
+    explicit PVStructurePool(StructureConstPtr const & type, size_t highWater = 16u, bool reset = true);
+    //! Destroys all free instances
+    ~PVStructurePool();
+
+    //! Get a recycled instance, or allocate a new one
+    PVStructurePtr get();
+
+    const StructureConstPtr& getStructure() const;
+
+    //! Current number of free instances
+    size_t freeCount() const;
+
+    size_t getHighWater() const;
+    //! Change the high water mark.  Excess free instances are destroyed immediately.
+    void setHighWater(size_t highWater);
+
+    static size_t num_instances;
+    //! Free instances in all pools
+    static size_t num_free;
+
+private:
+    struct Impl;
+    std::tr1::shared_ptr<Impl> impl;
+};
+
+}}
+
+#endif /* PVSTRUCTUREPOOL_H */
@@ -13,66 +13,48 @@
 
 namespace epics { namespace pvData {
 
-using std::tr1::static_pointer_cast;
 using std::size_t;
 
-static bool checkBitSetPVField(
-    PVFieldPtr const &pvField,BitSetPtr const &bitSet,int32 initialOffset)
+bool BitSetUtil::compress(BitSet& bitSet, const Structure& type)
 {
-    int32 offset = initialOffset;
-    int32 nbits = static_cast<int32>(pvField->getNumberFields());
-    if(nbits==1) return bitSet->get(offset);
-    int32 nextSetBit = bitSet->nextSetBit(offset);
-    if(nextSetBit>=(offset+nbits)) return false;
-    if(nextSetBit<0) return false;
-    if(bitSet->get(offset)) {
-        if(nbits>1) {
-            for(int32 i=offset+1; i<offset+nbits; i++) bitSet->clear(i);
-        }
-        return true;
-    }
+    const Structure::ranges_t& ranges = type.getStructureRanges();
 
-    bool atLeastOneBitSet = false;
-    bool allBitsSet = true;
-    PVStructurePtr pvStructure = static_pointer_cast<PVStructure>(pvField);
-    offset = static_cast<int32>(pvStructure->getFieldOffset()) + 1;
-    while(offset<initialOffset + nbits) {
-        PVFieldPtr pvSubField = pvStructure->getSubFieldT(offset);
-        int32 nbitsNow = static_cast<int32>(pvSubField->getNumberFields());
-        if(nbitsNow==1) {
-            if(bitSet->get(offset)) {
-                atLeastOneBitSet = true;
-            } else {
-                allBitsSet = false;
-            }
-            offset++;
-        } else {
-            bool result = checkBitSetPVField(pvSubField,bitSet,offset);
-            if(result) {
-                atLeastOneBitSet = true;
-                if(!bitSet->get(offset)) {
-                    allBitsSet = false;
-                }
-            } else {
-                allBitsSet = false;
-            }
-            offset += static_cast<int32>(pvSubField->getNumberFields());
-        }
+    int32 first = bitSet.nextSetBit(0);
+    if(first<0 || uint32(first)>=ranges[0].second)
+        return false;
+
+    // Visit nested structures before their parents.
+    // Mark complete structures by setting all of their bits.
+    // A structure is complete if its own bit is set,
+    // or if all of its sub-fields are set or complete.
+    for(size_t i=ranges.size(); i; i--) {
+        const Structure::range_t& R = ranges[i-1];
+        if(R.second-R.first<=1u)
+            continue; // empty structure is treated as a leaf
+
+        if(bitSet.get(R.first) || bitSet.allSet(R.first+1u, R.second))
+            bitSet.setRange(R.first, R.second);
     }
-    if(allBitsSet) {
-        if(nbits>1) {
-            for(int32 i=initialOffset+1; i<initialOffset+nbits; i++){
-                bitSet->clear(i);
-            }
+
+    // Visit parents before nested structures.
+    // Only the bit of the outermost complete structure remains.
+    uint32 skip = 0u;
+    for(size_t i=0, N=ranges.size(); i<N; i++) {
+        const Structure::range_t& R = ranges[i];
+        if(R.first<skip || R.second-R.first<=1u)
+            continue;
+
+        if(bitSet.get(R.first)) {
+            bitSet.clearRange(R.first+1u, R.second);
+            skip = R.second;
         }
-        bitSet->set(initialOffset);
     }
-    return atLeastOneBitSet;
+    return true;
 }
 
 bool BitSetUtil::compress(BitSetPtr const &bitSet,PVStructurePtr const &pvStructure)
 {
-    return checkBitSetPVField(pvStructure,bitSet,0);
+    return compress(*bitSet, *pvStructure->getStructure());
 }
 
 }}
@@ -31,6 +31,16 @@ public:
      *  @param pvStructure the structure.
      */
     static bool compress(BitSetPtr const &bitSet,PVStructurePtr const &pvStructure);
+
+    /**
+     *  compress the bitSet for an instance of a Structure.
+     *  Cost is linear in the number of nested structures, and bitSet words.
+     *  @param bitSet this must be a valid bitSet for type.
+     *  @param type the structure.
+     *  @returns true if any bit is set.
+     *  @version Added after 8.0.5
+     */
+    static bool compress(BitSet& bitSet, const Structure& type);
 };
 
 }}
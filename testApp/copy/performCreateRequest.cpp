@@ -0,0 +1,86 @@
+// Measure the time to parse pvRequest strings with createRequest().
+// Both repeated identical requests, as from many clients of the same
+// channel, and unique requests.
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+
+#include <string>
+#include <sstream>
+
+#include <testMain.h>
+#include <epicsUnitTest.h>
+#include <dbDefs.h> // for NELEMENTS
+
+#include <pv/current_function.h>
+#include <pv/createRequest.h>
+
+namespace {
+
+namespace pvd = epics::pvData;
+
+double now()
+{
+    struct timespec T;
+    clock_gettime(CLOCK_MONOTONIC, &T);
+    return T.tv_sec + T.tv_nsec*1e-9;
+}
+
+// a selection of nfields, with blanks
+std::string makeLarge(size_t nfields)
+{
+    std::ostringstream strm;
+    strm<<"record[process=true, block=false] field(";
+    for(size_t i=0; i<nfields; i++) {
+        if(i)
+            strm<<", ";
+        if(i%4==0)
+            strm<<"s"<<i<<"{value, alarm.severity}";
+        else if(i%4==1)
+            strm<<"f"<<i<<"[algorithm=onChange]";
+        else
+            strm<<"f"<<i;
+    }
+    strm<<")";
+    return strm.str();
+}
+
+void parse(const char *name, const std::string& request)
+{
+    testDiag("%s %s", CURRENT_FUNCTION, name);
+
+    const size_t reps = 1u + (2u<<20)/request.size();
+
+    // repeated identical request
+    double start = now();
+    for(size_t n=0; n<reps; n++) {
+        pvd::PVStructurePtr R(pvd::createRequest(request));
+    }
+    const double trepeat = (now() - start)/reps;
+
+    // distinct requests
+    std::string unique(request);
+    unique += "putField(x0000000)";
+    const size_t len = unique.size()-1u;
+    start = now();
+    for(size_t n=0; n<reps; n++) {
+        for(size_t i=0, v=n; i<7u; i++, v/=10u)
+            unique[len-1u-i] = '0'+(v%10u);
+        pvd::PVStructurePtr R(pvd::createRequest(unique));
+    }
+    const double tunique = (now() - start)/reps;
+
+    printf("# %s %u chars  repeated %f us  unique %f us\n", name, (unsigned)request.size(),
+           trepeat*1e6, tunique*1e6);
+}
+
+} // namespace
+
+MAIN(performCreateRequest) {
+    testPlan(0);
+    parse("simple", "field(value)");
+    parse("typical", "record[process=true]field(alarm,timeStamp[algorithm=onChange,causeMonitor=false],power{value,alarm})");
+    parse("large", makeLarge(50u));
+    parse("huge", makeLarge(500u));
+    return testDone();
+}
@@ -341,6 +341,32 @@ static void testBadRequest()
     // duplicate fieldName C
     // correct is: "field(A,C{D,E.F})"
     testThrows(std::invalid_argument, createRequest("field(A,C.D,C.E.F)"));
+
+    // malformed field names
+    testThrows(std::invalid_argument, createRequest("field(a{b}c)"));
+    testThrows(std::invalid_argument, createRequest("field(,a)"));
+    testThrows(std::invalid_argument, createRequest("field(a,,b)"));
+    testThrows(std::invalid_argument, createRequest("field(a[x=1][y=2])"));
+    testThrows(std::invalid_argument, createRequest("field(a.{b})"));
+    testThrows(std::runtime_error, createRequest("field(a,)"));
+}
+
+// repeated requests are parsed once
+static void testRequestCache()
+{
+    const char *request = "record[process=true]field(alarm,timeStamp[algorithm=onChange],power{value})";
+    PVStructurePtr A(createRequest(request)),
+                   B(createRequest(request));
+
+    testOk1(A!=B);
+    testOk1(A->getStructure()==B->getStructure());
+    testFieldEqual<PVString>(B, "field.timeStamp._options.algorithm", "onChange");
+
+    // a returned instance may be modified, without affecting later requests
+    B->getSubFieldT<PVString>("record._options.process")->put("false");
+    PVStructurePtr C(createRequest(request));
+    testFieldEqual<PVString>(C, "record._options.process", "true");
+    testOk1(*A==*C);
 }
 
 static
@@ -697,13 +723,161 @@ void testMaskErr()
     testThrows(std::runtime_error, PVRequestMapper mapper(*base, *createRequest("field(invalid)"), PVRequestMapper::Slice));
 }
 
+// copy of runs of adjacent fields
+void testMapperRuns(PVRequestMapper::mode_t mode)
+{
+    testDiag("=== %s mode==%d", CURRENT_FUNCTION, (int)mode);
+
+    StructureConstPtr type(getFieldCreate()->createFieldBuilder()
+                           ->addNestedStructure("x")
+                               ->add("a", pvInt)
+                               ->add("b", pvInt)
+                               ->add("c", pvInt)
+                               ->add("d", pvDouble)
+                               ->add("s", pvString)
+                               ->addArray("arr", pvInt)
+                           ->endNested()
+                           ->addNestedStructure("y")
+                               ->add("p", pvShort)
+                               ->add("q", pvShort)
+                           ->endNested()
+                           ->add("z", pvInt)
+                           ->createStructure());
+
+    PVStructurePtr base(getPVDataCreate()->createPVStructure(type));
+    PVRequestMapper mapper(*base, *createRequest("field(y,x{b,c,d,s,arr},z)"), mode);
+
+    base->getSubFieldT<PVInt>("x.a")->put(1);
+    base->getSubFieldT<PVInt>("x.b")->put(2);
+    base->getSubFieldT<PVInt>("x.c")->put(3);
+    base->getSubFieldT<PVDouble>("x.d")->put(4.5);
+    base->getSubFieldT<PVString>("x.s")->put("hello");
+    {
+        PVIntArray::svector arr(3, 7);
+        base->getSubFieldT<PVIntArray>("x.arr")->replace(freeze(arr));
+    }
+    base->getSubFieldT<PVShort>("y.p")->put(5);
+    base->getSubFieldT<PVShort>("y.q")->put(6);
+    base->getSubFieldT<PVInt>("z")->put(8);
+
+    const char *masks[][4] = {
+        {"x.c"},          // middle of a run
+        {"x.b", "x.c"},   // whole run of int
+        {"x.c", "x.d", "y.q"},
+        {"x"},            // compress bit
+        {"x.b", "x.c", "x.d", "z"},
+    };
+
+    for(size_t m=0; m<sizeof(masks)/sizeof(masks[0]); m++) {
+        BitSet baseMask;
+        std::string names;
+        for(size_t j=0; j<4 && masks[m][j]; j++) {
+            baseMask.set(base->getSubFieldT(masks[m][j])->getFieldOffset());
+            names += masks[m][j];
+            names += ' ';
+        }
+
+        PVStructurePtr req(mapper.buildRequested());
+        BitSet reqMask, expectMask;
+        mapper.copyBaseToRequested(*base, baseMask, *req, reqMask);
+        mapper.maskBaseToRequested(baseMask, expectMask);
+
+        // copied fields are equal to base, others are defaults
+        PVStructurePtr pristine(mapper.buildRequested());
+        bool ok = true;
+        for(size_t i=1, N=req->getNextFieldOffset(); i<N; i++) {
+            PVFieldPtr fld(req->getSubFieldT(i));
+            if(fld->getField()->getType()==structure)
+                continue;
+            const PVField& expect = reqMask.get(i) ? *base->getSubFieldT(fld->getFullName())
+                                                    : *pristine->getSubFieldT(i);
+            if(*fld!=expect) {
+                testDiag("Mismatch in %s", fld->getFullName().c_str());
+                ok = false;
+            }
+        }
+        testOk(ok, "copy %s", names.c_str());
+        testEqual(reqMask, expectMask);
+    }
+
+    {
+        PVStructurePtr req(mapper.buildRequested());
+        BitSet reqMask;
+        mapper.copyBaseToRequested(*base, BitSet().set(0), *req, reqMask);
+
+        req->getSubFieldT<PVInt>("x.b")->put(12);
+        req->getSubFieldT<PVInt>("x.c")->put(13);
+        req->getSubFieldT<PVShort>("y.q")->put(16);
+
+        PVStructurePtr base2(getPVDataCreate()->createPVStructure(type));
+        BitSet baseMask;
+        mapper.copyBaseFromRequested(*base2, baseMask, *req, BitSet().set(0));
+
+        testFieldEqual<PVInt>(base2, "x.a", 0);
+        testFieldEqual<PVInt>(base2, "x.b", 12);
+        testFieldEqual<PVInt>(base2, "x.c", 13);
+        testFieldEqual<PVDouble>(base2, "x.d", 4.5);
+        testFieldEqual<PVString>(base2, "x.s", "hello");
+        testEqual(base2->getSubFieldT<PVIntArray>("x.arr")->getLength(), 3u);
+        testFieldEqual<PVShort>(base2, "y.p", 5);
+        testFieldEqual<PVShort>(base2, "y.q", 16);
+        testFieldEqual<PVInt>(base2, "z", 8);
+    }
+}
+
+void testMapperCache()
+{
+    testDiag("=== %s", CURRENT_FUNCTION);
+
+    PVStructurePtr base(getPVDataCreate()->createPVStructure(maskingType));
+    const size_t initial = PVRequestMapper::cacheSize();
+
+    std::tr1::shared_ptr<const PVRequestMapper> A(PVRequestMapper::lookup(*base, *createRequest("field(B,C.D)"), PVRequestMapper::Slice)),
+                                                B(PVRequestMapper::lookup(*base, *createRequest("field(B, C{D})"), PVRequestMapper::Slice)),
+                                                C(PVRequestMapper::lookup(*base, *createRequest("field(B,C.D)"), PVRequestMapper::Mask)),
+                                                D(PVRequestMapper::lookup(*base, *createRequest("field(B,C.D)record[keepIDs=true]"), PVRequestMapper::Slice)),
+                                                E(PVRequestMapper::lookup(*base, *createRequest("field(C.D,B)"), PVRequestMapper::Slice));
+
+    testOk1(A==B);
+    testOk1(A!=C);
+    testOk1(A!=D);
+    testOk1(A!=E);
+    testEqual(PVRequestMapper::cacheSize(), initial+4u);
+
+    // a different base Structure
+    StructureConstPtr other(getFieldCreate()->createFieldBuilder()
+                            ->add("B", pvInt)
+                            ->createStructure());
+    std::tr1::shared_ptr<const PVRequestMapper> F(PVRequestMapper::lookup(*other->build(), *createRequest("field(B)"), PVRequestMapper::Slice));
+    testOk1(F->base()==other);
+
+    testThrows(std::runtime_error, PVRequestMapper::lookup(*base, *createRequest("field(invalid)"), PVRequestMapper::Slice));
+
+    // a shared mapper used with caller provided scratch
+    PVStructurePtr req(A->buildRequested());
+    base->getSubFieldT<PVInt>("B")->put(42);
+    BitSet reqMask, scratch;
+    A->copyBaseToRequested(*base, BitSet().set(0), *req, reqMask, scratch);
+    testFieldEqual<PVInt>(req, "B", 42);
+
+    // entries expire with the last reference
+    A.reset();
+    B.reset();
+    C.reset();
+    D.reset();
+    E.reset();
+    F.reset();
+    testEqual(PVRequestMapper::cacheSize(), initial);
+}
+
 } // namespace
 
 MAIN(testCreateRequest)
 {
-    testPlan(315);
+    testPlan(373);
     testCreateRequestInternal();
     testBadRequest();
+    testRequestCache();
     testMapper(PVRequestMapper::Slice);
     testMapper(PVRequestMapper::Mask);
 #undef TEST_METHOD
@@ -728,5 +902,8 @@ MAIN(testCreateRequest)
     TEST_METHOD(MapperMask, testMaskSub2R2B);
     testMaskWarn();
     testMaskErr();
+    testMapperRuns(PVRequestMapper::Slice);
+    testMapperRuns(PVRequestMapper::Mask);
+    testMapperCache();
     return testDone();
 }
@@ -0,0 +1,140 @@
+// Measure the time for common BitSet operations.
+// Iteration of set bits with nextSetBit() and BitSet::const_iterator,
+// cardinality(), bulk logical operations, and copying.
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+
+#include <testMain.h>
+#include <epicsUnitTest.h>
+#include <dbDefs.h> // for NELEMENTS
+
+#include <pv/current_function.h>
+#include <pv/bitSet.h>
+
+namespace {
+
+namespace pvd = epics::pvData;
+
+double now()
+{
+    struct timespec T;
+    clock_gettime(CLOCK_MONOTONIC, &T);
+    return T.tv_sec + T.tv_nsec*1e-9;
+}
+
+// nbits with every 'stride' bit set
+pvd::BitSet makeSet(pvd::uint32 nbits, pvd::uint32 stride)
+{
+    pvd::BitSet ret;
+    for(pvd::uint32 i=0; i<nbits; i+=stride)
+        ret.set(i);
+    ret.set(nbits-1u);
+    return ret;
+}
+
+void iterate(pvd::uint32 nbits, pvd::uint32 stride)
+{
+    testDiag("%s nbits=%u stride=%u", CURRENT_FUNCTION, (unsigned)nbits, (unsigned)stride);
+
+    const pvd::BitSet B(makeSet(nbits, stride));
+    const size_t reps = 1u + (16u<<20)/nbits;
+
+    // prevent the loops from being optimized away
+    volatile pvd::uint32 sink = 0;
+
+    double start = now();
+    for(size_t n=0; n<reps; n++) {
+        pvd::uint32 sum = 0;
+        for(pvd::int32 i=B.nextSetBit(0); i>=0; i=B.nextSetBit(i+1))
+            sum += i;
+        sink = sink + sum;
+    }
+    const double tnext = (now() - start)/reps;
+
+    start = now();
+    for(size_t n=0; n<reps; n++) {
+        pvd::uint32 sum = 0;
+        for(pvd::BitSet::const_iterator it(B.begin()), end(B.end()); it!=end; ++it)
+            sum += *it;
+        sink = sink + sum;
+    }
+    const double titer = (now() - start)/reps;
+
+    start = now();
+    for(size_t n=0; n<reps; n++) {
+        sink = sink + B.cardinality();
+    }
+    const double tcard = (now() - start)/reps;
+
+    printf("# %u bits, %u set  nextSetBit() %f ns  iterator %f ns  cardinality() %f ns\n",
+           (unsigned)nbits, (unsigned)B.cardinality(),
+           tnext*1e9, titer*1e9, tcard*1e9);
+}
+
+void logical(pvd::uint32 nbits)
+{
+    testDiag("%s nbits=%u", CURRENT_FUNCTION, (unsigned)nbits);
+
+    const pvd::BitSet A(makeSet(nbits, 3u)), B(makeSet(nbits, 5u));
+    pvd::BitSet R;
+    const size_t reps = 1u + (64u<<20)/nbits;
+
+    // each operation repeated, as a single operation is comparable to the clock resolution
+    R = A;
+    double start = now();
+    for(size_t n=0; n<reps; n++)
+        R |= B;
+    const double tor = now() - start;
+
+    start = now();
+    for(size_t n=0; n<reps; n++)
+        R &= A;
+    const double tand = now() - start;
+
+    start = now();
+    for(size_t n=0; n<reps; n++)
+        R ^= B; // alternates
+    const double txor = now() - start;
+
+    printf("# %u bits  |= %f ns  &= %f ns  ^= %f ns\n",
+           (unsigned)nbits, tor/reps*1e9, tand/reps*1e9, txor/reps*1e9);
+}
+
+// copy, as for each subscriber of a monitor
+void copy(pvd::uint32 nbits)
+{
+    testDiag("%s nbits=%u", CURRENT_FUNCTION, (unsigned)nbits);
+
+    const pvd::BitSet A(makeSet(nbits, 3u));
+    const size_t reps = 1u<<20;
+    volatile pvd::uint32 sink = 0;
+
+    double start = now();
+    for(size_t n=0; n<reps; n++) {
+        pvd::BitSet C(A);
+        sink = sink + C.size();
+    }
+    const double tcopy = now() - start;
+
+    printf("# %u bits  copy %f ns\n", (unsigned)nbits, tcopy/reps*1e9);
+}
+
+} // namespace
+
+MAIN(performBitSet) {
+    testPlan(0);
+    const pvd::uint32 sizes[] = {64u, 256u, 4096u, 65536u};
+    for(size_t i=0; i<NELEMENTS(sizes); i++) {
+        iterate(sizes[i], 1u);
+        iterate(sizes[i], 7u);
+        iterate(sizes[i], 100u);
+    }
+    for(size_t i=0; i<NELEMENTS(sizes); i++) {
+        logical(sizes[i]);
+    }
+    copy(64u);
+    copy(128u);
+    copy(256u);
+    return testDone();
+}
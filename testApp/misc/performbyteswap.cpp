@@ -0,0 +1,110 @@
+// Measure the time to byte swap arrays with ByteBuffer::putArray() and getArray()
+// compared with an element-wise loop, as used previously.
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+
+#include <vector>
+
+#include <testMain.h>
+#include <epicsUnitTest.h>
+#include <dbDefs.h> // for NELEMENTS
+
+#include <pv/current_function.h>
+#include <pv/byteBuffer.h>
+
+namespace {
+
+namespace pvd = epics::pvData;
+
+double now()
+{
+    struct timespec T;
+    clock_gettime(CLOCK_MONOTONIC, &T);
+    return T.tv_sec + T.tv_nsec*1e-9;
+}
+
+// the element-wise loop
+template<typename T>
+void putLoop(pvd::ByteBuffer& buf, const T* values, size_t count)
+{
+    char *pos = const_cast<char*>(buf.getBuffer())+buf.getPosition();
+    for(size_t i=0; i<count; i++) {
+        pvd::detail::store_unaligned(pos+i*sizeof(T), pvd::swap<T>(values[i]));
+    }
+    buf.setPosition(buf.getPosition()+count*sizeof(T));
+}
+
+template<typename T>
+void getLoop(pvd::ByteBuffer& buf, T* values, size_t count)
+{
+    const char *pos = buf.getBuffer()+buf.getPosition();
+    for(size_t i=0; i<count; i++) {
+        values[i] = pvd::swap<T>(pvd::detail::load_unaligned<T>(pos+i*sizeof(T)));
+    }
+    buf.setPosition(buf.getPosition()+count*sizeof(T));
+}
+
+template<typename T>
+void swapArray(size_t count, bool loop)
+{
+    testDiag("%s count=%zu loop=%c", CURRENT_FUNCTION, count, loop ? 'Y' : 'N');
+
+    const int order = EPICS_BYTE_ORDER==EPICS_ENDIAN_BIG ? EPICS_ENDIAN_LITTLE : EPICS_ENDIAN_BIG;
+
+    std::vector<T> vals(count, T(42));
+    pvd::ByteBuffer buf(count*sizeof(T)+1u, order);
+
+    // aim for ~64 MB processed in each direction
+    const size_t reps = 1u + (64u<<20)/(count*sizeof(T));
+
+    double tput = 0.0, tget = 0.0;
+
+    for(size_t n=0; n<reps; n++) {
+        buf.clear();
+        buf.setPosition(1); // unaligned, as within a message
+
+        double start = now();
+        if(loop)
+            putLoop(buf, &vals[0], count);
+        else
+            buf.putArray(&vals[0], count);
+        tput += now() - start;
+
+        buf.flip();
+        buf.setPosition(1);
+
+        start = now();
+        if(loop)
+            getLoop(buf, &vals[0], count);
+        else
+            buf.getArray(&vals[0], count);
+        tget += now() - start;
+    }
+
+    printf("# %zu x %zu bytes  put %f ns/elem %f GB/s  get %f ns/elem %f GB/s\n",
+           count, sizeof(T),
+           tput/reps/count*1e9, reps*count*sizeof(T)/tput*1e-9,
+           tget/reps/count*1e9, reps*count*sizeof(T)/tget*1e-9);
+}
+
+template<typename T>
+void sweep()
+{
+    const size_t counts[] = {16u, 256u, 4096u, 65536u, 1048576u};
+    for(size_t i=0; i<NELEMENTS(counts); i++) {
+        swapArray<T>(counts[i], true);
+        swapArray<T>(counts[i], false);
+    }
+}
+
+} // namespace
+
+MAIN(performByteSwap) {
+    testPlan(0);
+    sweep<pvd::uint16>();
+    sweep<pvd::uint32>();
+    sweep<pvd::uint64>();
+    sweep<double>();
+    return testDone();
+}
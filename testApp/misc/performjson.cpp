@@ -0,0 +1,123 @@
+// Measure the time to parse and print JSON arrays of increasing length.
+// Time per element should not grow with length.
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+
+#include <sstream>
+#include <vector>
+
+#include <testMain.h>
+#include <epicsUnitTest.h>
+
+#include <pv/current_function.h>
+#include <pv/pvData.h>
+#include <pv/json.h>
+
+namespace {
+
+namespace pvd = epics::pvData;
+
+double now()
+{
+    struct timespec T;
+    clock_gettime(CLOCK_MONOTONIC, &T);
+    return T.tv_sec + T.tv_nsec*1e-9;
+}
+
+void parseArray(size_t nelem, pvd::ScalarType etype, bool frombuf=false)
+{
+    testDiag("%s nelem=%zu type=%s frombuf=%c", CURRENT_FUNCTION, nelem,
+             pvd::ScalarTypeFunc::name(etype), frombuf ? 'Y' : 'N');
+
+    pvd::StructureConstPtr type(pvd::getFieldCreate()->createFieldBuilder()
+                                ->addArray("value", etype)
+                                ->createStructure());
+
+    std::ostringstream strm;
+    strm<<"{\"value\": [";
+    for(size_t i=0; i<nelem; i++) {
+        if(i)
+            strm<<", ";
+        if(etype==pvd::pvString)
+            strm<<"\"elem"<<i<<"\"";
+        else
+            strm<<i;
+    }
+    strm<<"]}";
+    const std::string input(strm.str());
+
+    const size_t reps = 5u;
+    double total = 0.0;
+
+    for(size_t n=0; n<reps; n++) {
+        pvd::PVStructurePtr val(type->build());
+        std::istringstream src(input);
+
+        double start = now();
+        if(frombuf)
+            pvd::parseJSON(input.c_str(), input.size(), *val);
+        else
+            pvd::parseJSON(src, *val);
+        total += now() - start;
+    }
+
+    printf("# %zu elements  %f ms per parse  %f ns per element\n",
+           nelem, total/reps*1e3, total/reps/nelem*1e9);
+}
+
+void printArray(size_t nelem, pvd::ScalarType etype, bool tobuf)
+{
+    testDiag("%s nelem=%zu type=%s tobuf=%c", CURRENT_FUNCTION, nelem,
+             pvd::ScalarTypeFunc::name(etype), tobuf ? 'Y' : 'N');
+
+    pvd::PVStructurePtr val(pvd::getFieldCreate()->createFieldBuilder()
+                            ->addArray("value", etype)
+                            ->createStructure()->build());
+    {
+        pvd::PVDoubleArray::svector arr(nelem);
+        for(size_t i=0; i<nelem; i++)
+            arr[i] = i/3.0;
+        val->getSubFieldT<pvd::PVScalarArray>("value")->putFrom(pvd::freeze(arr));
+    }
+
+    pvd::JSONPrintOptions opts;
+    opts.multiLine = false;
+
+    const size_t reps = 5u;
+    double total = 0.0;
+    std::vector<char> buf;
+
+    for(size_t n=0; n<reps; n++) {
+        double start = now();
+        if(tobuf) {
+            buf.clear(); // re-use
+            pvd::printJSON(buf, *val, opts);
+        } else {
+            std::ostringstream strm;
+            pvd::printJSON(strm, *val, opts);
+        }
+        total += now() - start;
+    }
+
+    printf("# %zu elements  %f ms per print  %f ns per element\n",
+           nelem, total/reps*1e3, total/reps/nelem*1e9);
+}
+
+} // namespace
+
+MAIN(performjson) {
+    testPlan(0);
+    parseArray(1000, pvd::pvDouble);
+    parseArray(10000, pvd::pvDouble);
+    parseArray(100000, pvd::pvDouble);
+    parseArray(1000, pvd::pvString);
+    parseArray(10000, pvd::pvString);
+    parseArray(100000, pvd::pvString);
+    parseArray(100000, pvd::pvDouble, true);
+    printArray(100000, pvd::pvDouble, false);
+    printArray(100000, pvd::pvDouble, true);
+    printArray(100000, pvd::pvInt, true);
+    printArray(100000, pvd::pvString, true);
+    return testDone();
+}
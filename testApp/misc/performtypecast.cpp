@@ -0,0 +1,113 @@
+// Measure the time for castUnsafeV() to convert arrays between
+// all pairs of numeric types, and to/from std::string.
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+
+#include <vector>
+#include <string>
+
+#include <testMain.h>
+#include <epicsUnitTest.h>
+#include <dbDefs.h> // for NELEMENTS
+
+#include <pv/current_function.h>
+#include <pv/typeCast.h>
+
+namespace {
+
+namespace pvd = epics::pvData;
+
+double now()
+{
+    struct timespec T;
+    clock_gettime(CLOCK_MONOTONIC, &T);
+    return T.tv_sec + T.tv_nsec*1e-9;
+}
+
+const pvd::ScalarType types[] = {
+    pvd::pvByte, pvd::pvUByte, pvd::pvShort, pvd::pvUShort,
+    pvd::pvInt, pvd::pvUInt, pvd::pvLong, pvd::pvULong,
+    pvd::pvFloat, pvd::pvDouble,
+};
+
+const char *names[] = {"byte", "ubyte", "short", "ushort", "int", "uint", "long", "ulong", "float", "double"};
+
+// prints ns per element, rows by source type, columns by destination type
+void matrix(size_t count)
+{
+    testDiag("%s count=%u", CURRENT_FUNCTION, (unsigned)count);
+
+    // large enough for any numeric type
+    std::vector<double> vals(count), sbuf(count), dbuf(count);
+    for(size_t i=0; i<count; i++)
+        vals[i] = double(i%100u);
+
+    const size_t reps = 1u + (64u<<20)/count;
+
+    printf("# %u elements.  ns per element.  FROM (rows) -> TO (columns)\n#       ", (unsigned)count);
+    for(size_t t=0; t<NELEMENTS(types); t++)
+        printf(" %7s", names[t]);
+    printf("\n");
+
+    for(size_t f=0; f<NELEMENTS(types); f++) {
+        // fill source with small values, valid in all types
+        pvd::castUnsafeV(count, types[f], &sbuf[0], pvd::pvDouble, &vals[0]);
+
+        printf("# %6s", names[f]);
+        for(size_t t=0; t<NELEMENTS(types); t++) {
+            double start = now();
+            for(size_t n=0; n<reps; n++)
+                pvd::castUnsafeV(count, types[t], &dbuf[0], types[f], &sbuf[0]);
+            const double T = (now() - start)/reps/count;
+            printf(" %7.3f", T*1e9);
+        }
+        printf("\n");
+    }
+}
+
+// prints ns per element to print and to parse
+void strings(size_t count)
+{
+    testDiag("%s count=%u", CURRENT_FUNCTION, (unsigned)count);
+
+    const pvd::ScalarType stypes[] = {pvd::pvInt, pvd::pvLong, pvd::pvFloat, pvd::pvDouble};
+    const char *snames[] = {"int", "long", "float", "double"};
+
+    std::vector<double> vals(count), sbuf(count), dbuf(count);
+    std::vector<std::string> strs(count);
+
+    const size_t reps = 1u + (4u<<20)/count;
+
+    printf("# %u elements.  ns per element\n#         to string  from string\n", (unsigned)count);
+
+    for(size_t f=0; f<NELEMENTS(stypes); f++) {
+        // values with a mix of magnitudes and digits
+        srand(42);
+        for(size_t i=0; i<count; i++)
+            vals[i] = (rand()-RAND_MAX/2) / double(1u<<(rand()%16));
+        pvd::castUnsafeV(count, stypes[f], &sbuf[0], pvd::pvDouble, &vals[0]);
+
+        double start = now();
+        for(size_t n=0; n<reps; n++)
+            pvd::castUnsafeV(count, pvd::pvString, &strs[0], stypes[f], &sbuf[0]);
+        const double T1 = (now() - start)/reps/count;
+
+        start = now();
+        for(size_t n=0; n<reps; n++)
+            pvd::castUnsafeV(count, stypes[f], &dbuf[0], pvd::pvString, &strs[0]);
+        const double T2 = (now() - start)/reps/count;
+
+        printf("# %6s %10.1f %12.1f\n", snames[f], T1*1e9, T2*1e9);
+    }
+}
+
+} // namespace
+
+MAIN(performTypeCast) {
+    testPlan(0);
+    matrix(1024u);
+    matrix(1024u*1024u);
+    strings(1024u);
+    return testDone();
+}
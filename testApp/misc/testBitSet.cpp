@@ -303,15 +303,165 @@ static void testSerialize()
 #undef TOFRO
 }
 
+// indices of set bits found with nextSetBit()
+static std::vector<uint32> setBits(const BitSet& B)
+{
+    std::vector<uint32> ret;
+    for(int32 i=B.nextSetBit(0); i>=0; i=B.nextSetBit(i+1))
+        ret.push_back(i);
+    return ret;
+}
+
+static void testIterator()
+{
+    testDiag("testIterator()");
+
+    {
+        BitSet empty;
+        testOk1(empty.begin()==empty.end());
+    }
+
+    const uint32 bits[] = {0, 1, 63, 64, 65, 127, 200, 1000, 1023};
+
+    for(size_t n=0; n<NELEMENTS(bits); n++) {
+        BitSet B;
+        B.set(bits[n]);
+        BitSet::const_iterator it(B.begin());
+        testOk(it!=B.end() && *it==bits[n] && ++it==B.end(), "only bit %u", (unsigned)bits[n]);
+    }
+
+    BitSet B;
+    for(size_t n=0; n<NELEMENTS(bits); n++)
+        B.set(bits[n]);
+    B.clear(1023); // leaves trailing words with leading zero words
+
+    std::vector<uint32> actual;
+    for(BitSet::const_iterator it(B.begin()), end(B.end()); it!=end; it++)
+        actual.push_back(*it);
+
+    testOk1(actual==setBits(B));
+    testEqual(actual.size(), B.cardinality());
+}
+
+static void testBulk()
+{
+    testDiag("testBulk()");
+
+    // lengths which exercise both vector and scalar steps
+    const uint32 lengths[] = {1, 64, 65, 128, 129, 300, 1000};
+
+    for(size_t n=0; n<NELEMENTS(lengths); n++) {
+        for(size_t m=0; m<NELEMENTS(lengths); m++) {
+            BitSet A, B;
+            for(uint32 i=0; i<lengths[n]; i+=3)
+                A.set(i);
+            for(uint32 i=0; i<lengths[m]; i+=5)
+                B.set(i);
+
+            BitSet AND(A), OR(A), XOR(A), EXPAND, EXPOR, EXPXOR;
+            AND &= B;
+            OR |= B;
+            XOR ^= B;
+
+            for(uint32 i=0, N=std::max(lengths[n], lengths[m]); i<N; i++) {
+                if(A.get(i) && B.get(i))
+                    EXPAND.set(i);
+                if(A.get(i) || B.get(i))
+                    EXPOR.set(i);
+                if(A.get(i) != B.get(i))
+                    EXPXOR.set(i);
+            }
+
+            testOk(AND==EXPAND && OR==EXPOR && XOR==EXPXOR && XOR.cardinality()==EXPXOR.cardinality(),
+                   "lengths %u, %u", (unsigned)lengths[n], (unsigned)lengths[m]);
+        }
+    }
+}
+
+static void testRange()
+{
+    testDiag("testRange()");
+
+    const uint32 edges[] = {0, 1, 5, 63, 64, 65, 127, 128, 200};
+
+    for(size_t n=0; n<NELEMENTS(edges); n++) {
+        for(size_t m=n; m<NELEMENTS(edges); m++) {
+            const uint32 from = edges[n], to = edges[m];
+
+            // background of every 3rd bit, up to 300
+            BitSet bg;
+            for(uint32 i=0; i<300; i+=3)
+                bg.set(i);
+
+            BitSet S(bg), C(bg), ES(bg), EC(bg);
+            S.setRange(from, to);
+            C.clearRange(from, to);
+            for(uint32 i=from; i<to; i++) {
+                ES.set(i);
+                EC.clear(i);
+            }
+
+            // with no background, clearRange() must leave an empty set
+            BitSet E;
+            E.setRange(from, to);
+            E.clearRange(from, to);
+
+            testOk(S==ES && C==EC && E.isEmpty()
+                   && S.allSet(from, to) && (from==to || !C.allSet(from, to)),
+                   "range [%u, %u)", (unsigned)from, (unsigned)to);
+        }
+    }
+}
+
+// copy and swap between inline and heap allocated storage
+static void testStorage()
+{
+    testDiag("testStorage()");
+
+    // highest bit inline, at limit of inline, and heap
+    const uint32 bits[] = {5, 64*PVD_BITSET_INLINE_WORDS-1, 64*PVD_BITSET_INLINE_WORDS, 1000};
+
+    for(size_t n=0; n<NELEMENTS(bits); n++) {
+        for(size_t m=0; m<NELEMENTS(bits); m++) {
+            BitSet A, B;
+            A.set(3).set(bits[n]);
+            B.set(2).set(bits[m]);
+            const BitSet expectA(A), expectB(B);
+
+            BitSet C(A);
+            C = B;
+            bool ok = C==expectB;
+            C = A;
+            ok &= C==expectA;
+
+            A.swap(B);
+            ok &= A==expectB && B==expectA;
+            A.swap(B);
+            ok &= A==expectA && B==expectB;
+
+            B.clear();
+            ok &= B.isEmpty();
+            B = A;
+            ok &= B==expectA && B.cardinality()==2u;
+
+            testOk(ok, "bits %u, %u", (unsigned)bits[n], (unsigned)bits[m]);
+        }
+    }
+}
+
 } // namespace
 
 MAIN(testBitSet)
 {
-    testPlan(90);
+    testPlan(212);
     testInitialize();
     testGetSetClearFlip();
     testOperators();
     testLogical();
     testSerialize();
+    testIterator();
+    testBulk();
+    testStorage();
+    testRange();
     return testDone();
 }
@@ -13,6 +13,8 @@
 #include <fstream>
 #include <cstring>
 #include <memory>
+#include <vector>
+#include <algorithm>
 
 #include <testMain.h>
 
@@ -271,9 +273,62 @@ void testArrayBE()
     testEqual(vals[1], 0xa1a2a3a4u);
 }
 
+// compare swapped putArray()/getArray() with element-wise swap()
+// for all lengths through several vector widths, and unaligned buffer positions.
+template<typename T>
+static
+void testArraySwap()
+{
+    testDiag("testArraySwap() sizeof(T)=%u", (unsigned)sizeof(T));
+
+    const int order = EPICS_BYTE_ORDER==EPICS_ENDIAN_BIG ? EPICS_ENDIAN_LITTLE : EPICS_ENDIAN_BIG;
+    const size_t maxcount = 150u;
+
+    std::vector<T> vals(maxcount), out(maxcount);
+    for(size_t i=0; i<maxcount; i++) {
+        uint64 v = 0x0102030405060708ull*(i+1u);
+        memcpy(&vals[i], &v, sizeof(T));
+    }
+
+    ByteBuffer buf(maxcount*sizeof(T)+1u, order);
+    bool putok = true, getok = true;
+
+    for(size_t offset=0; offset<2u; offset++) {
+        for(size_t count=0; count<=maxcount; count++) {
+            buf.clear();
+            buf.setPosition(offset);
+            buf.putArray(&vals[0], count);
+
+            for(size_t i=0; i<count; i++) {
+                T expect(swap<T>(vals[i]));
+                if(memcmp(&expect, buf.getBuffer()+offset+i*sizeof(T), sizeof(T))!=0) {
+                    testDiag("put mismatch offset=%u count=%u at %u",
+                             (unsigned)offset, (unsigned)count, (unsigned)i);
+                    putok = false;
+                    break;
+                }
+            }
+
+            buf.flip();
+            buf.setPosition(offset);
+            std::fill(out.begin(), out.end(), T(0));
+            buf.getArray(&out[0], count);
+
+            // compare bytes as patterns may be NaN
+            if(count && memcmp(&vals[0], &out[0], count*sizeof(T))!=0) {
+                testDiag("get mismatch offset=%u count=%u", (unsigned)offset, (unsigned)count);
+                getok = false;
+            }
+        }
+    }
+
+    testOk(putok, "putArray() swapped");
+    testOk(getok, "getArray() swapped");
+}
+
 MAIN(testByteBuffer)
 {
-    testPlan(97);
+    testPlan(105);
     testDiag("Tests byteBuffer");
     testBasicOperations();
     testInverseEndianness(EPICS_ENDIAN_BIG, expect_be);
@@ -282,5 +337,9 @@ MAIN(testByteBuffer)
     testUnaligned();
     testArrayLE();
     testArrayBE();
+    testArraySwap<uint16>();
+    testArraySwap<uint32>();
+    testArraySwap<uint64>();
+    testArraySwap<double>();
     return testDone();
 }
@@ -9,6 +9,8 @@
  *      Author: Miha Vitorovic
  */
 
+#include <string.h>
+
 #include <iostream>
 #include <fstream>
 
@@ -23,6 +25,7 @@
 #include <pv/serialize.h>
 #include <pv/noDefaultMethods.h>
 #include <pv/byteBuffer.h>
+#include <pv/bitSet.h>
 #include <pv/convert.h>
 #include <pv/pvUnitTest.h>
 #include <pv/current_function.h>
@@ -825,6 +828,323 @@ void testToString(int byteOrder)
     printbytes(bytes.size(), &bytes[0]);
 }
 
+// larger than the staging buffer of serializeToVector()
+static
+void testToStringLarge(int byteOrder)
+{
+    testDiag("testToStringLarge(%d)", byteOrder);
+
+    PVStructurePtr _data(getFieldCreate()->createFieldBuilder()
+                         ->add("X", pvInt)
+                         ->addArray("small", pvShort)
+                         ->addArray("large", pvDouble)
+                         ->add("Y", pvString)
+                         ->add("Z", pvLong)
+                         ->createStructure()->build());
+
+    _data->getSubFieldT<PVInt>("X")->put(42);
+    _data->getSubFieldT<PVString>("Y")->put(std::string(20000u, 'y'));
+    _data->getSubFieldT<PVLong>("Z")->put(-5);
+    {
+        PVShortArray::svector arr(3, 7);
+        _data->getSubFieldT<PVShortArray>("small")->replace(freeze(arr));
+    }
+    {
+        PVDoubleArray::svector arr(100000u);
+        for(size_t i=0; i<arr.size(); i++)
+            arr[i] = i*1.5;
+        _data->getSubFieldT<PVDoubleArray>("large")->replace(freeze(arr));
+    }
+
+    ByteBuffer expect(1u<<20, byteOrder);
+    _data->serialize(&expect, flusher);
+
+    std::vector<epicsUInt8> bytes(2u, 0xff); // results appended
+    serializeToVector(_data.get(), byteOrder, bytes);
+
+    testEqual(bytes.size(), expect.getPosition()+2u);
+    testOk(bytes.size()==expect.getPosition()+2u && memcmp(&bytes[2], expect.getBuffer(), expect.getPosition())==0,
+           "serializeToVector() matches");
+
+    PVStructurePtr _other(_data->getStructure()->build());
+    ByteBuffer buf((char*)&bytes[2], bytes.size()-2u, byteOrder);
+    deserializeFromBuffer(_other.get(), buf);
+    testEqual(*_other, *_data);
+}
+
+// compare the prediction with the number of bytes actually serialized
+void testSizeOf(const Serializable *S, size_t predicted, const char *what)
+{
+    std::vector<epicsUInt8> bytes;
+    serializeToVector(S, EPICS_BYTE_ORDER, bytes);
+    testOk(bytes.size()==predicted, "%s getSerializedSize() %u == %u",
+           what, (unsigned)predicted, (unsigned)bytes.size());
+}
+
+void testSerializedSize()
+{
+    testDiag("testSerializedSize()");
+
+    StructureConstPtr type(getFieldCreate()->createFieldBuilder()
+                           ->setId("test:type")
+                           ->add("X", pvInt)
+                           ->add("S", pvString)
+                           ->addArray("arr", pvDouble)
+                           ->addArray("sarr", pvString)
+                           ->addFixedArray("fixed", pvShort, 4)
+                           ->addBoundedString("bounded", 300)
+                           ->add("any", getFieldCreate()->createVariantUnion())
+                           ->addNestedUnion("choice")
+                                ->add("A", pvInt)
+                                ->add("B", pvString)
+                           ->endNested()
+                           ->addNestedStructure("sub")
+                                ->add("Y", pvDouble)
+                                ->add("Z", pvUByte)
+                           ->endNested()
+                           ->addNestedStructureArray("sa")
+                                ->add("Q", pvInt)
+                           ->endNested()
+                           ->addNestedUnionArray("ua")
+                                ->add("R", pvFloat)
+                           ->endNested()
+                           ->createStructure());
+
+    testSizeOf(type.get(), type->getSerializedSize(), "Structure");
+    testSizeOf(type->getField("choice").get(), type->getField("choice")->getSerializedSize(), "Union");
+    testSizeOf(type->getField("sa").get(), type->getField("sa")->getSerializedSize(), "StructureArray");
+
+    PVStructurePtr val(type->build());
+    // fixed size array must be full
+    {
+        PVShortArray::svector arr(4u, 1);
+        val->getSubFieldT<PVShortArray>("fixed")->replace(freeze(arr));
+    }
+
+    testSizeOf(val.get(), val->getSerializedSize(), "default PVStructure");
+
+    val->getSubFieldT<PVString>("S")->put(std::string(1000u, 's'));
+    {
+        PVDoubleArray::svector arr(300u, 1.0);
+        val->getSubFieldT<PVDoubleArray>("arr")->replace(freeze(arr));
+    }
+    {
+        PVStringArray::svector arr(3u);
+        arr[1] = "hello";
+        val->getSubFieldT<PVStringArray>("sarr")->replace(freeze(arr));
+    }
+    val->getSubFieldT<PVString>("bounded")->put("bound");
+    val->getSubFieldT<PVUnion>("any")->set(val->getSubFieldT("sub")->getField()->build());
+    val->getSubFieldT<PVUnion>("choice")->select<PVString>("B")->put("choice");
+    {
+        PVStructureArrayPtr sa(val->getSubFieldT<PVStructureArray>("sa"));
+        PVStructureArray::svector arr(3u);
+        arr[0] = sa->getStructureArray()->getStructure()->build();
+        arr[2] = sa->getStructureArray()->getStructure()->build();
+        sa->replace(freeze(arr));
+    }
+    {
+        PVUnionArrayPtr ua(val->getSubFieldT<PVUnionArray>("ua"));
+        PVUnionArray::svector arr(2u);
+        arr[1] = getPVDataCreate()->createPVUnion(ua->getUnionArray()->getUnion());
+        arr[1]->select(0);
+        ua->replace(freeze(arr));
+    }
+
+    testSizeOf(val.get(), val->getSerializedSize(), "PVStructure");
+    testSizeOf(val->getSubFieldT("any").get(), val->getSubFieldT("any")->getSerializedSize(), "variant PVUnion");
+
+    // partial
+    BitSet changed;
+    changed.set(val->getSubFieldT("S")->getFieldOffset());
+    changed.set(val->getSubFieldT("sub.Z")->getFieldOffset());
+    changed.set(val->getSubFieldT("sa")->getFieldOffset());
+
+    ByteBuffer buf(1u<<16);
+    val->serialize(&buf, flusher, &changed);
+    testEqual(val->getSerializedSize(changed), buf.getPosition());
+
+    changed.clear();
+    changed.set(0);
+    testEqual(val->getSerializedSize(changed), val->getSerializedSize());
+}
+
+void testSegments(int byteOrder)
+{
+    testDiag("testSegments(%d)", byteOrder);
+
+    PVStructurePtr _data(getFieldCreate()->createFieldBuilder()
+                         ->add("X", pvInt)
+                         ->addArray("small", pvShort)
+                         ->addArray("large", pvDouble)
+                         ->add("Y", pvString)
+                         ->createStructure()->build());
+
+    _data->getSubFieldT<PVInt>("X")->put(42);
+    _data->getSubFieldT<PVString>("Y")->put("hello");
+    {
+        PVShortArray::svector arr(3, 7);
+        _data->getSubFieldT<PVShortArray>("small")->replace(freeze(arr));
+    }
+    PVDoubleArray::const_svector large;
+    {
+        PVDoubleArray::svector arr(10000u);
+        for(size_t i=0; i<arr.size(); i++)
+            arr[i] = i*1.5;
+        large = freeze(arr);
+        _data->getSubFieldT<PVDoubleArray>("large")->replace(large);
+    }
+
+    std::vector<epicsUInt8> expect;
+    serializeToVector(_data.get(), byteOrder, expect);
+
+    SerializedSegments segs;
+    segs.serialize(_data.get(), byteOrder);
+
+    // replacing the value does not invalidate the segments
+    const void *largeData = large.data();
+    large.clear();
+    _data->getSubFieldT<PVDoubleArray>("large")->replace(PVDoubleArray::const_svector());
+
+    std::vector<epicsUInt8> actual;
+    segs.copyTo(actual);
+
+    testEqual(segs.size(), expect.size());
+    testOk(actual==expect, "segments match serializeToVector()");
+
+    if(byteOrder==EPICS_BYTE_ORDER) {
+        // header, large array body, trailer
+        testEqual(segs.segments().size(), 3u);
+        testEqual(segs.referenceCount(), 1u);
+        testOk1(segs.segments().size()==3u && segs.segments()[1].base==largeData);
+    } else {
+        // swapped array values are copied
+        testEqual(segs.segments().size(), 1u);
+        testEqual(segs.referenceCount(), 0u);
+        testPass("no references");
+    }
+
+    segs.clear();
+    testEqual(segs.size(), 0u);
+}
+
+void testFromShared(int byteOrder)
+{
+    testDiag("testFromShared(%d)", byteOrder);
+
+    PVStructurePtr _data(getFieldCreate()->createFieldBuilder()
+                         ->addArray("large", pvDouble)
+                         ->add("X", pvInt)
+                         ->createStructure()->build());
+    {
+        PVDoubleArray::svector arr(1000u);
+        for(size_t i=0; i<arr.size(); i++)
+            arr[i] = i*1.5;
+        _data->getSubFieldT<PVDoubleArray>("large")->replace(freeze(arr));
+    }
+    _data->getSubFieldT<PVInt>("X")->put(42);
+
+    std::vector<epicsUInt8> bytes;
+    serializeToVector(_data.get(), byteOrder, bytes);
+
+    // array values follow the 5 byte size.  Pad so that they are aligned
+    const size_t pad = 3u;
+    std::tr1::shared_ptr<std::vector<epicsUInt8> > rx(new std::vector<epicsUInt8>(pad));
+    rx->insert(rx->end(), bytes.begin(), bytes.end());
+
+    PVStructurePtr _other(_data->getStructure()->build());
+    {
+        ByteBuffer buf((char*)&(*rx)[0], rx->size(), byteOrder);
+        buf.setPosition(pad);
+        deserializeFromBuffer(_other.get(), buf, rx);
+        testEqual(buf.getRemaining(), 0u);
+    }
+    testOk(*_other==*_data, "round trip");
+
+    PVDoubleArray::const_svector large(_other->getSubFieldT<PVDoubleArray>("large")->view());
+    const bool inplace = (const void*)large.data()==(const void*)&(*rx)[pad+5u];
+    const bool aligned = ((size_t)&(*rx)[pad+5u])%sizeof(double)==0u;
+
+    if(byteOrder==EPICS_BYTE_ORDER && aligned) {
+        testOk(inplace, "values referenced in place");
+        // released with the last reference
+        std::tr1::weak_ptr<std::vector<epicsUInt8> > wrx(rx);
+        rx.reset();
+        testOk1(!wrx.expired());
+        large.clear();
+        _other.reset();
+        testOk1(wrx.expired());
+    } else {
+        testOk(!inplace, "values copied");
+        testSkip(2, "not referenced");
+    }
+}
+
+// storage borrowed from a receive buffer must not be modified through one of its users
+void testFromSharedReuse()
+{
+    testDiag("testFromSharedReuse()");
+
+    PVStructurePtr _data(getFieldCreate()->createFieldBuilder()
+                         ->addArray("arr", pvInt)
+                         ->createStructure()->build());
+    PVIntArrayPtr arr(_data->getSubFieldT<PVIntArray>("arr"));
+    {
+        PVIntArray::svector vals(10u, 1);
+        arr->replace(freeze(vals));
+    }
+
+    // array values follow the 1 byte size.  Pad so that they are aligned
+    const size_t pad = 3u;
+    std::tr1::shared_ptr<std::vector<epicsUInt8> > rx(new std::vector<epicsUInt8>(pad));
+    {
+        std::vector<epicsUInt8> bytes;
+        serializeToVector(_data.get(), EPICS_BYTE_ORDER, bytes);
+        rx->insert(rx->end(), bytes.begin(), bytes.end());
+    }
+
+    PVStructurePtr A(_data->getStructure()->build()),
+                   B(_data->getStructure()->build());
+    PVIntArrayPtr Aarr(A->getSubFieldT<PVIntArray>("arr")),
+                  Barr(B->getSubFieldT<PVIntArray>("arr"));
+    for(unsigned i=0; i<2u; i++) {
+        ByteBuffer buf((char*)&(*rx)[0], rx->size(), EPICS_BYTE_ORDER);
+        buf.setPosition(pad);
+        deserializeFromBuffer(i==0u ? A.get() : B.get(), buf, rx);
+    }
+    testDiag("A %s in place", Aarr->view().data()==(const int32*)&(*rx)[pad+1u] ? "is" : "not");
+
+    {
+        PVIntArray::svector mine(Aarr->reuse());
+        testOk1(mine.data()!=(const int32*)&(*rx)[pad+1u]);
+        mine[0] = 999;
+    }
+    testEqual(Barr->view()[0], 1);
+
+    // deserialize into A again from the shared buffer, then from a private copy
+    {
+        ByteBuffer buf((char*)&(*rx)[0], rx->size(), EPICS_BYTE_ORDER);
+        buf.setPosition(pad);
+        deserializeFromBuffer(A.get(), buf, rx);
+    }
+    {
+        PVIntArray::svector vals(10u, 2);
+        arr->replace(freeze(vals));
+    }
+    {
+        std::vector<epicsUInt8> bytes;
+        serializeToVector(_data.get(), EPICS_BYTE_ORDER, bytes);
+        ByteBuffer buf((char*)&bytes[0], bytes.size(), EPICS_BYTE_ORDER);
+        deserializeFromBuffer(A.get(), buf);
+    }
+    testEqual(Aarr->view()[0], 2);
+    testEqual(Barr->view()[0], 1);
+    testEqual(Barr->view()[9], 1);
+    int32 first;
+    memcpy(&first, &(*rx)[pad+1u], sizeof(first));
+    testEqual(first, 1);
+}
+
 void testFromString(int byteOrder)
 {
     testDiag("testFromString(%d)", byteOrder);
@@ -853,7 +1173,7 @@ void testFromString(int byteOrder)
 
 MAIN(testSerialization) {
 
-    testPlan(234);
+    testPlan(276);
 
     flusher = new SerializableControlImpl();
     control = new DeserializableControlImpl();
@@ -877,6 +1197,14 @@ MAIN(testSerialization) {
 
     testToString(EPICS_ENDIAN_BIG);
     testToString(EPICS_ENDIAN_LITTLE);
+    testToStringLarge(EPICS_ENDIAN_BIG);
+    testToStringLarge(EPICS_ENDIAN_LITTLE);
+    testSerializedSize();
+    testSegments(EPICS_ENDIAN_BIG);
+    testSegments(EPICS_ENDIAN_LITTLE);
+    testFromShared(EPICS_ENDIAN_BIG);
+    testFromShared(EPICS_ENDIAN_LITTLE);
+    testFromSharedReuse();
     testFromString(EPICS_ENDIAN_BIG);
     testFromString(EPICS_ENDIAN_LITTLE);
 
@@ -373,6 +373,18 @@ void testVoid()
     testOk1(IV.dataOffset()==1);
     testOk1(IV.size()==2);
     VV.clear();
+
+    // capacity is preserved through void
+    IV.clear();
+    IV.reserve(8);
+    IV.push_back(1);
+    VV = pvd::static_shared_vector_cast<void>(IV);
+    testOk1(VV.dataTotal()==8*sizeof(pvd::int32));
+    IV.clear();
+    IV = pvd::static_shared_vector_cast<pvd::int32>(VV);
+    VV.clear();
+    testOk1(IV.size()==1);
+    testOk1(IV.capacity()==8);
 }
 
 void testConstVoid()
@@ -698,7 +710,7 @@ void testCXX11Init()
 
 MAIN(testSharedVector)
 {
-    testPlan(192);
+    testPlan(195);
     testDiag("Tests for shared_vector");
 
     testDiag("sizeof(shared_vector<pvd::int32>)=%lu",
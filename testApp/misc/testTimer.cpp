@@ -16,10 +16,14 @@
 #include <cstdio>
 #include <iostream>
 #include <exception>
+#include <vector>
+#include <sstream>
+#include <cmath>
 
 #include <epicsUnitTest.h>
 #include <testMain.h>
 #include <epicsGuard.h>
+#include <epicsThread.h>
 
 #include <pv/timeStamp.h>
 #include <pv/event.h>
@@ -91,6 +95,93 @@ Mutex MyCallback::gbl_mutex;
 
 typedef std::tr1::shared_ptr<MyCallback> MyCallbackPtr;
 
+// records the order in which callbacks run
+struct OrderCallback : public TimerCallback
+{
+    POINTER_DEFINITIONS(OrderCallback);
+
+    explicit OrderCallback(unsigned expect) :expect(expect), actual(0u) {}
+    virtual ~OrderCallback() {}
+    virtual void callback()
+    {
+        epicsGuard<Mutex> G(gbl_mutex);
+        actual = gbl_counter++;
+        if(gbl_counter==gbl_total)
+            done.signal();
+    }
+    virtual void timerStopped() {}
+
+    const unsigned expect;
+    unsigned actual;
+
+    static unsigned gbl_counter, gbl_total;
+    static Mutex gbl_mutex;
+    static Event done;
+};
+
+unsigned OrderCallback::gbl_counter;
+unsigned OrderCallback::gbl_total;
+Mutex OrderCallback::gbl_mutex;
+Event OrderCallback::done;
+
+struct NullCallback : public TimerCallback
+{
+    POINTER_DEFINITIONS(NullCallback);
+    virtual ~NullCallback() {}
+    virtual void callback() {}
+    virtual void timerStopped() {}
+};
+
+// periodic callback which takes longer than its period
+struct SlowCallback : public TimerCallback
+{
+    POINTER_DEFINITIONS(SlowCallback);
+
+    SlowCallback() :count(0u), concurrent(0u), maxConcurrent(0u) {}
+    virtual ~SlowCallback() {}
+    virtual void callback()
+    {
+        {
+            epicsGuard<Mutex> G(lock);
+            count++;
+            concurrent++;
+            if(concurrent>maxConcurrent)
+                maxConcurrent = concurrent;
+        }
+        epicsThreadSleep(0.01);
+        {
+            epicsGuard<Mutex> G(lock);
+            concurrent--;
+        }
+    }
+    virtual void timerStopped() {}
+
+    Mutex lock;
+    unsigned count, concurrent, maxConcurrent;
+};
+
+// periodic callback which records when it runs
+struct TimesCallback : public TimerCallback
+{
+    POINTER_DEFINITIONS(TimesCallback);
+
+    explicit TimesCallback(double busy) :busy(busy) {}
+    virtual ~TimesCallback() {}
+    virtual void callback()
+    {
+        {
+            epicsGuard<Mutex> G(lock);
+            times.push_back(epicsTime::getCurrent());
+        }
+        epicsThreadSleep(busy);
+    }
+    virtual void timerStopped() {}
+
+    const double busy;
+    Mutex lock;
+    std::vector<epicsTime> times;
+};
+
 }// namespace
 
 static void testBasic(unsigned oneOrd, unsigned twoOrd, unsigned threeOrd)
@@ -219,9 +310,263 @@ static void testCancel(unsigned oneOrd, unsigned twoOrd, unsigned threeOrd,
     }
 }
 
+// callbacks expire in order of delay, and in order of scheduling for equal delays
+static void testOrder()
+{
+    testDiag("testOrder");
+
+    const unsigned N = 200u;
+
+    Timer timer("timer" ,middlePriority);
+
+    Marker::shared_pointer marker(new Marker);
+    timer.scheduleAfterDelay(marker, 0.0);
+    marker->wait.wait();
+    // timer worker is blocked
+
+    OrderCallback::gbl_counter = 0u;
+    OrderCallback::gbl_total = N;
+
+    // schedule N/2 distinct delays, each twice, in a scrambled order.
+    // delays far enough apart that the time spent scheduling doesn't matter.
+    std::vector<OrderCallback::shared_pointer> cbs(N);
+    for(unsigned i=0; i<N/2u; i++) {
+        unsigned slot = (i*37u)%(N/2u);
+        cbs[2u*slot].reset(new OrderCallback(2u*slot));
+        cbs[2u*slot+1u].reset(new OrderCallback(2u*slot+1u));
+        timer.scheduleAfterDelay(cbs[2u*slot], 0.01 + slot*1e-3);
+        timer.scheduleAfterDelay(cbs[2u*slot+1u], 0.01 + slot*1e-3);
+    }
+
+    marker->hold.signal(); // let the worker loose
+
+    OrderCallback::done.wait();
+
+    unsigned wrong = 0u;
+    {
+        epicsGuard<Mutex> G(OrderCallback::gbl_mutex);
+        for(unsigned i=0; i<N; i++) {
+            if(cbs[i]->actual!=cbs[i]->expect && wrong++<5u)
+                testDiag("callback %u ran as %u", cbs[i]->expect, cbs[i]->actual);
+        }
+    }
+    testOk(wrong==0u, "%u of %u run out of order", wrong, N);
+}
+
+// schedule and cancel many callbacks
+static void testScaling()
+{
+    const size_t N = 100000u;
+
+    testDiag("testScaling with %u callbacks", (unsigned)N);
+
+    Timer timer("timer" ,middlePriority);
+
+    std::vector<NullCallback::shared_pointer> cbs(N);
+    for(size_t i=0; i<N; i++)
+        cbs[i].reset(new NullCallback);
+
+    srand(1234);
+
+    epicsTime start(epicsTime::getCurrent());
+    // far enough in the future to never expire
+    for(size_t i=0; i<N; i++)
+        timer.scheduleAfterDelay(cbs[i], 1000.0 + (rand()%100000)*0.01);
+    epicsTime end(epicsTime::getCurrent());
+
+    testDiag("schedule %.3f us per callback", (end-start)/N*1e6);
+
+    size_t sched = 0u;
+    for(size_t i=0; i<N; i++)
+        sched += timer.isScheduled(cbs[i]);
+    testOk(sched==N, "%u of %u scheduled", (unsigned)sched, (unsigned)N);
+
+    size_t cancelled = 0u;
+    start = epicsTime::getCurrent();
+    for(size_t i=0; i<N; i+=2u)
+        cancelled += timer.cancel(cbs[i]);
+    end = epicsTime::getCurrent();
+
+    testDiag("cancel %.3f us per callback", (end-start)/(N/2u)*1e6);
+    testOk(cancelled==N/2u, "cancelled %u of %u", (unsigned)cancelled, (unsigned)N/2u);
+
+    size_t wrong = 0u;
+    for(size_t i=0; i<N; i++)
+        wrong += timer.isScheduled(cbs[i]) != (i%2u==1u);
+    testOk(wrong==0u, "%u wrong after cancel", (unsigned)wrong);
+
+    for(size_t i=N; i>0u; i--)
+        timer.cancel(cbs[i-1u]);
+
+    sched = 0u;
+    for(size_t i=0; i<N; i++)
+        sched += timer.isScheduled(cbs[i]);
+    testOk(sched==0u, "%u scheduled after cancel all", (unsigned)sched);
+}
+
+// a blocked callback doesn't delay others when run by workers
+static void testWorkers()
+{
+    testDiag("testWorkers");
+
+    Timer timer(Timer::Config("pool").workers(2u));
+
+    Marker::shared_pointer marker(new Marker);
+    MyCallbackPtr callbackOne(new MyCallback("one"));
+
+    timer.scheduleAfterDelay(marker, 0.0);
+    marker->wait.wait();
+    // one worker is blocked
+
+    timer.scheduleAfterDelay(callbackOne, 0.01);
+    testOk(callbackOne->wait.wait(5.0), "run while another callback is blocked");
+    testOk1(!timer.isScheduled(callbackOne));
+
+    marker->hold.signal();
+    // wait for workers to complete
+    timer.close();
+
+    TimerLateness L(timer.getLateness(callbackOne));
+    testOk(L.count==1u && L.max>=0.0 && L.max<5.0, "lateness count=%u max=%g",
+           (unsigned)L.count, L.max);
+}
+
+// with serialize() a periodic callback never overlaps itself
+static void testSerialize(bool serialize)
+{
+    testDiag("testSerialize(%c)", serialize ? 'Y' : 'N');
+
+    SlowCallback::shared_pointer slow(new SlowCallback);
+    size_t missed;
+    {
+        Timer timer(Timer::Config("pool").workers(4u).serialize(serialize));
+
+        timer.schedulePeriodic(slow, 0.0, 0.001);
+        epicsThreadSleep(0.2);
+
+        testOk1(timer.getLateness(slow).count>1u);
+        // without serialize, periods are skipped while all workers are busy
+        missed = timer.getLateness(slow).missed;
+
+        if(serialize) {
+            testOk1(timer.cancel(slow));
+            epicsThreadSleep(0.05);
+            testOk1(!timer.isScheduled(slow));
+        }
+    }
+
+    if(!serialize)
+        testOk(missed>0u, "missed %u", (unsigned)missed);
+
+    epicsGuard<Mutex> G(slow->lock);
+    if(serialize)
+        testOk(slow->maxConcurrent==1u, "max concurrent %u", slow->maxConcurrent);
+    else
+        testOk(slow->maxConcurrent>1u, "max concurrent %u", slow->maxConcurrent);
+}
+
+// cancel a periodic callback which expired again while running
+static void testCancelRerun()
+{
+    testDiag("testCancelRerun");
+
+    Timer timer(Timer::Config("pool").workers(2u));
+
+    Marker::shared_pointer marker(new Marker);
+    timer.schedulePeriodic(marker, 0.0, 0.01);
+    marker->wait.wait();
+    // running, and blocked
+
+    testOk1(timer.cancel(marker));
+    timer.schedulePeriodic(marker, 0.0, 0.01);
+    epicsThreadSleep(0.05);
+    // expired again while still running
+    testOk1(timer.cancel(marker));
+
+    marker->hold.signal();
+    epicsThreadSleep(0.1);
+    testOk(!marker->wait.tryWait(), "not run after cancel");
+    testOk1(!timer.isScheduled(marker));
+
+    marker->hold.signal();
+    timer.close();
+}
+
+// the time taken by a periodic callback doesn't add to its period
+static void testNoDrift()
+{
+    testDiag("testNoDrift");
+
+    const double period = 0.02;
+    TimesCallback::shared_pointer cb(new TimesCallback(0.005));
+    {
+        Timer timer("timer" ,middlePriority);
+        timer.schedulePeriodic(cb, 0.0, period);
+        epicsThreadSleep(0.5);
+    }
+
+    epicsGuard<Mutex> G(cb->lock);
+    size_t N = cb->times.size();
+    testOk(N>=10u, "ran %u times", (unsigned)N);
+    if(N>=2u) {
+        double avg = (cb->times[N-1u] - cb->times[0])/(N-1u);
+        testOk(fabs(avg-period) < 0.2*period, "average period %g ~= %g", avg, period);
+    } else {
+        testFail("too few");
+    }
+}
+
+// with coalesce(), periods missed while overloaded are skipped
+static void testCoalesce()
+{
+    testDiag("testCoalesce");
+
+    TimerLateness L[2];
+    for(unsigned i=0; i<2u; i++) {
+        bool coalesce = i==0u;
+        TimesCallback::shared_pointer cb(new TimesCallback(0.02));
+        Timer timer(Timer::Config("timer").coalesce(coalesce));
+        timer.schedulePeriodic(cb, 0.0, 0.005);
+        epicsThreadSleep(0.2);
+
+        std::ostringstream strm;
+        timer.dump(strm);
+        testOk(strm.str().find("lateness count")!=std::string::npos, "dump shows lateness");
+
+        timer.close();
+        L[i] = timer.getLateness(cb);
+        testDiag("coalesce=%c count %u missed %u max %g", coalesce ? 'Y' : 'N',
+                 (unsigned)L[i].count, (unsigned)L[i].missed, L[i].max);
+    }
+
+    testOk(L[0].missed>0u, "coalesce missed %u", (unsigned)L[0].missed);
+    testOk(L[1].missed==0u, "no coalesce missed %u", (unsigned)L[1].missed);
+    testOk(L[0].max < L[1].max, "coalesce max late %g < %g", L[0].max, L[1].max);
+}
+
+// delays too large to represent, and periods too short
+static void testExtremes()
+{
+    testDiag("testExtremes");
+
+    TimesCallback::shared_pointer never(new TimesCallback(0.0)),
+                                  often(new TimesCallback(0.001));
+    Timer timer("timer" ,middlePriority);
+    timer.scheduleAfterDelay(never, 1e300);
+    timer.schedulePeriodic(often, 0.0, 1e-12);
+    epicsThreadSleep(0.1);
+
+    testOk1(timer.isScheduled(never));
+    timer.close();
+
+    epicsGuard<Mutex> G1(never->lock), G2(often->lock);
+    testOk(never->times.empty() && often->times.size()>1u, "ran %u and %u times",
+           (unsigned)never->times.size(), (unsigned)often->times.size());
+}
+
 MAIN(testTimer)
 {
-    testPlan(315);
+    testPlan(343);
     try {
         testDiag("Tests timer");
 
@@ -234,6 +579,16 @@ MAIN(testTimer)
         testBasic(0, 2, 1);
         testCancel(0, 2, 1, 0, 1);
 
+        testOrder();
+        testScaling();
+        testWorkers();
+        testSerialize(true);
+        testSerialize(false);
+        testCancelRerun();
+        testNoDrift();
+        testCoalesce();
+        testExtremes();
+
     }catch(std::exception& e) {
         testFail("Unhandled exception: %s", e.what());
     }
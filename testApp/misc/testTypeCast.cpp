@@ -114,12 +114,57 @@ namespace {
 
 #define FAIL(TTO, TFRO, VFRO) testfail<TTO,TFRO>::op(VFRO)
 
+    // castUnsafeV() of an array longer than one block, with a remainder
+    template<typename TO, typename FROM>
+    void testvcast(epics::pvData::ScalarType to, epics::pvData::ScalarType from)
+    {
+        FROM in[37];
+        TO out[37];
+        for(size_t i=0; i<37; i++)
+            in[i] = FROM(int(i)*3 - 20);
+
+        epics::pvData::castUnsafeV(37, to, (void*)out, from, (const void*)in);
+
+        bool ok = true;
+        for(size_t i=0; i<37; i++) {
+            if(!testequal<TO>::op(out[i], ::epics::pvData::castUnsafe<TO,FROM>(in[i]))) {
+                testDiag("element %u differs", (unsigned)i);
+                ok = false;
+            }
+        }
+        testOk(ok, "vcast %s -> %s", typeid(FROM).name(), typeid(TO).name());
+    }
+
+    // print to string and parse back an assortment of bit patterns
+    template<typename T, typename I>
+    void testroundtrip()
+    {
+        epicsUInt64 seed = 1u;
+        size_t bad = 0u;
+        for(size_t n=0; n<10000; n++) {
+            seed = seed*6364136223846793005ull + 1442695040888963407ull;
+            I bits = I(seed>>(64u-8u*sizeof(I)));
+            T val;
+            memcpy(&val, &bits, sizeof(val));
+            if(val!=val || val-val!=0)
+                continue; // skip NaN and Inf
+            if(val!=0 && fabs(val)<std::numeric_limits<T>::min())
+                continue; // sub-normal parsing reports ERANGE
+
+            string str(::epics::pvData::castUnsafe<string>(val));
+            T parsed = ::epics::pvData::castUnsafe<T>(str);
+            if(memcmp(&parsed, &val, sizeof(val))!=0 && bad++<5)
+                testDiag("%s doesn't round trip", str.c_str());
+        }
+        testOk(bad==0, "%s round trip", typeid(T).name());
+    }
+
 } // end namespace
 
 
 MAIN(testTypeCast)
 {
-    testPlan(124);
+    testPlan(148);
 
 try {
 
@@ -354,9 +399,22 @@ try {
     TEST2(string, "1.1e+100", double, 1.1e100);
     TEST2(string, "1.1e-100", double, 1.1e-100);
 
+    TEST2(string, "0.1", double, 0.1);
+    TEST2(string, "0.1", float, 0.1f);
+    TEST2(string, "0.30000000000000004", double, 0.1+0.2);
+
     TEST(double, 1.1e100, string, "1.1E+100");
     TEST(double, 1.1e100, const char*, "1.1E+100");
 
+    // types other than the ScalarType are printed with std::ostream
+    TEST(string, "-5", long long, -5);
+    TEST(string, "5", unsigned long long, 5u);
+    TEST(string, "5", unsigned long, 5u);
+    {
+        char cbuf[] = "hello";
+        TEST(string, "hello", char*, cbuf);
+    }
+
     // any non-zero value is true
     TEST(string, "true", epics::pvData::boolean, 100);
 
@@ -393,6 +451,11 @@ try {
     TEST(int64_t, -7, string, "-07");
     TEST(int64_t, -8, string, "-010");
 
+    TEST(int32_t, 12, string, " 12 ");
+    TEST(int32_t, 5, string, "+5");
+    TEST(double, 16.0, string, "0x10");
+    TEST(double, 0.5, string, " 5e-1\t");
+
     testDiag("string parsing errors");
 
     FAIL(int32_t, string, "hello!");
@@ -405,6 +468,10 @@ try {
     FAIL(int8_t, string, "1000");
     FAIL(int8_t, string, "-1000");
 
+    FAIL(uint8_t, string, "256");
+    FAIL(int64_t, string, "9223372036854775808");
+    FAIL(uint64_t, string, "18446744073709551616");
+
     FAIL(double, string, "1e+1000");
     FAIL(double, string, "-1e+1000");
 
@@ -438,6 +505,26 @@ try {
         testOk1(result[2]=="42424242");
     }
 
+    testroundtrip<double, epicsUInt64>();
+    testroundtrip<float, epicsUInt32>();
+
+    testvcast<double, int16_t>(epics::pvData::pvDouble, epics::pvData::pvShort);
+    testvcast<int32_t, double>(epics::pvData::pvInt, epics::pvData::pvDouble);
+    testvcast<float, uint8_t>(epics::pvData::pvFloat, epics::pvData::pvUByte);
+    testvcast<int8_t, int64_t>(epics::pvData::pvByte, epics::pvData::pvLong);
+
+    {
+        const string in[3] = { "1", "2", "x" };
+        int32_t result[3];
+        try {
+            epics::pvData::castUnsafeV(3, epics::pvData::pvInt, (void*)result,
+                                       epics::pvData::pvString, (const void*)in);
+            testFail("vcast string -> int32 should fail");
+        } catch(std::runtime_error& e) {
+            testOk(strstr(e.what(), "index 2")!=NULL, "vcast fails with: %s", e.what());
+        }
+    }
+
 } catch(std::exception& e) {
     testAbort("Uncaught exception: %s", e.what());
 }
@@ -3,6 +3,10 @@
  * found in the file LICENSE that is included with the distribution
  */
 
+#include <sstream>
+
+#include <stdio.h>
+
 #include <testMain.h>
 
 #include <pv/pvdVersion.h>
@@ -271,11 +275,206 @@ void testroundtrip()
                       "}");
 }
 
+struct CountPosts : public pvd::PostHandler
+{
+    POINTER_DEFINITIONS(CountPosts);
+    size_t count;
+    CountPosts() :count(0u) {}
+    virtual ~CountPosts() {}
+    virtual void postPut() { count++; }
+};
+
+void testIntoLargeArray()
+{
+    testDiag("testIntoLargeArray()");
+
+    pvd::PVStructurePtr val(pvd::getFieldCreate()->createFieldBuilder()
+                            ->addArray("dvec", pvd::pvDouble)
+                            ->addArray("svec", pvd::pvString)
+                            ->createStructure()->build());
+
+    const size_t N = 10000u;
+    std::ostringstream strm;
+    strm<<"{\"dvec\": [";
+    for(size_t i=0; i<N; i++)
+        strm<<(i ? ", " : "")<<i<<".5";
+    strm<<"], \"svec\": [\"a\", \"b\"]}";
+
+    std::istringstream input(strm.str());
+    pvd::parseJSON(input, *val);
+
+    pvd::PVDoubleArray::const_svector dvec(val->getSubFieldT<pvd::PVDoubleArray>("dvec")->view());
+    testEqual(dvec.size(), N);
+    if(dvec.size()==N) {
+        testEqual(dvec[0], 0.5);
+        testEqual(dvec[N-1], N-0.5);
+    } else {
+        testSkip(2, "wrong size");
+    }
+
+    // elements are appended to existing content
+    std::istringstream input2("{\"svec\": [\"c\"]}");
+    pvd::parseJSON(input2, *val);
+
+    pvd::PVStringArray::svector expect(3);
+    expect[0] = "a";
+    expect[1] = "b";
+    expect[2] = "c";
+    testFieldEqual<pvd::PVStringArray>(val, "svec", pvd::freeze(expect));
+
+    // one postPut() per array
+    CountPosts::shared_pointer posts(new CountPosts);
+    val->getSubFieldT("svec")->setPostHandler(posts);
+    std::istringstream input3("{\"svec\": [\"d\", \"e\"]}");
+    pvd::parseJSON(input3, *val);
+    testEqual(posts->count, 1u);
+
+    // unchanged if parsing fails part way through an array
+    std::istringstream input4("{\"svec\": [\"f\", null]}");
+    testThrows(std::runtime_error, pvd::parseJSON(input4, *val));
+
+    pvd::PVStringArray::svector expect2(5);
+    expect2[0] = "a";
+    expect2[1] = "b";
+    expect2[2] = "c";
+    expect2[3] = "d";
+    expect2[4] = "e";
+    testFieldEqual<pvd::PVStringArray>(val, "svec", pvd::freeze(expect2));
+}
+
+void testPrintBuffer()
+{
+    testDiag("testPrintBuffer()");
+
+    pvd::PVStructurePtr val(pvd::getFieldCreate()->createFieldBuilder()
+                            ->add("d1", pvd::pvDouble)
+                            ->add("d2", pvd::pvDouble)
+                            ->add("d3", pvd::pvDouble)
+                            ->add("f", pvd::pvFloat)
+                            ->add("b", pvd::pvBoolean)
+                            ->add("i8", pvd::pvByte)
+                            ->add("lmin", pvd::pvLong)
+                            ->add("ulmax", pvd::pvULong)
+                            ->addArray("dvec", pvd::pvDouble)
+                            ->addArray("bvec", pvd::pvUByte)
+                            ->createStructure()->build());
+
+    val->getSubFieldT<pvd::PVDouble>("d1")->put(0.1);
+    val->getSubFieldT<pvd::PVDouble>("d2")->put(1.0/3.0);
+    val->getSubFieldT<pvd::PVDouble>("d3")->put(-2.0);
+    val->getSubFieldT<pvd::PVFloat>("f")->put(0.1f);
+    val->getSubFieldT<pvd::PVBoolean>("b")->put(true);
+    val->getSubFieldT<pvd::PVByte>("i8")->put(-5);
+    val->getSubFieldT<pvd::PVLong>("lmin")->put(-9223372036854775807LL-1);
+    val->getSubFieldT<pvd::PVULong>("ulmax")->put(18446744073709551615ULL);
+    {
+        pvd::PVDoubleArray::svector arr(3);
+        arr[0] = 1.5;
+        arr[1] = 1e300;
+        arr[2] = 0.0;
+        val->getSubFieldT<pvd::PVDoubleArray>("dvec")->replace(pvd::freeze(arr));
+    }
+    {
+        pvd::PVUByteArray::svector arr(2);
+        arr[0] = 0;
+        arr[1] = 255;
+        val->getSubFieldT<pvd::PVUByteArray>("bvec")->replace(pvd::freeze(arr));
+    }
+
+    pvd::JSONPrintOptions opts;
+    opts.multiLine = false;
+
+    std::vector<char> buf(1, 'X'); // output is appended
+    pvd::printJSON(buf, *val, opts);
+
+    std::string expect("X{\"d1\": 0.1,"
+                       "\"d2\": 0.3333333333333333,"
+                       "\"d3\": -2,"
+                       "\"f\": 0.1,"
+                       "\"b\": true,"
+                       "\"i8\": -5,"
+                       "\"lmin\": -9223372036854775808,"
+                       "\"ulmax\": 18446744073709551615,"
+                       "\"dvec\": [1.5,1e+300,0],"
+                       "\"bvec\": [0,255]}");
+    testEqual(std::string(buf.begin(), buf.end()), expect);
+
+    std::ostringstream strm;
+    pvd::printJSON(strm, *val, opts);
+    testEqual(strm.str(), expect.substr(1));
+
+    // doubles round trip exactly
+    buf.clear();
+    pvd::printJSON(buf, *val->getSubFieldT("d2"), opts);
+    pvd::PVDoublePtr d2(pvd::getPVDataCreate()->createPVScalar<pvd::PVDouble>());
+    std::istringstream input(std::string(buf.begin(), buf.end()));
+    pvd::parseJSON(input, *d2);
+    testEqual(d2->get(), 1.0/3.0);
+}
+
+void testChunked()
+{
+    testDiag("testChunked()");
+
+    pvd::PVStructurePtr expect(pvd::getPVDataCreate()->createPVStructure(bigtype));
+    pvd::BitSet expectAssigned;
+    {
+        std::istringstream strm(bigtest);
+        pvd::parseJSON(strm, *expect, &expectAssigned);
+    }
+
+    {
+        // one byte at a time
+        pvd::PVStructurePtr val(pvd::getPVDataCreate()->createPVStructure(bigtype));
+        pvd::BitSet assigned;
+        pvd::JSONParser parser(*val, &assigned);
+        for(size_t i=0; i<sizeof(bigtest)-1u; i++)
+            parser.feed(&bigtest[i], 1u);
+        parser.complete();
+
+        testEqual(*val, *expect);
+        testEqual(assigned, expectAssigned);
+    }
+
+    {
+        pvd::PVStructurePtr val(pvd::getPVDataCreate()->createPVStructure(bigtype));
+        pvd::parseJSON(bigtest, sizeof(bigtest)-1u, *val);
+
+        testEqual(*val, *expect);
+    }
+
+    {
+        const char fname[] = "testjson.tmp.json";
+        {
+            FILE *fp = fopen(fname, "wb");
+            if(!fp)
+                testAbort("Unable to create %s", fname);
+            fwrite(bigtest, 1, sizeof(bigtest)-1u, fp);
+            fclose(fp);
+        }
+
+        pvd::PVStructurePtr val(pvd::getPVDataCreate()->createPVStructure(bigtype));
+        pvd::parseJSONFile(fname, *val);
+        remove(fname);
+
+        testEqual(*val, *expect);
+
+        testThrows(std::runtime_error, pvd::parseJSONFile(fname, *val));
+    }
+
+    {
+        pvd::PVStructurePtr val(pvd::getPVDataCreate()->createPVStructure(bigtype));
+        pvd::JSONParser parser(*val);
+        parser.feed("{\"scalar\":", 10u);
+        testThrows(std::runtime_error, parser.complete());
+    }
+}
+
 } // namespace
 
 MAIN(testjson)
 {
-    testPlan(29);
+    testPlan(45);
     try {
         testparseany();
         testparseanyarray();
@@ -283,6 +482,9 @@ MAIN(testjson)
         testparseanyjunk();
         testInto();
         testroundtrip();
+        testIntoLargeArray();
+        testPrintBuffer();
+        testChunked();
     }catch(std::exception& e){
         testAbort("Unexpected exception: %s", e.what());
     }
@@ -43,13 +43,29 @@ struct TimeIt {
     }
 };
 
-void buildMiss()
+// append 'width' copies of the usual NT meta-data sub-structures.
+// Wider types have more members to hash and compare.
+pvd::FieldBuilderPtr addMeta(const pvd::FieldBuilderPtr& builder, size_t width)
 {
-    testDiag("%s", CURRENT_FUNCTION);
+    pvd::StandardFieldPtr standard(pvd::getStandardField());
+
+    for(size_t i=0; i<width; i++) {
+        char buf[16];
+        sprintf(buf, "%zu", i);
+        builder->add(std::string("alarm")+buf, standard->alarm())
+                ->add(std::string("timeStamp")+buf, standard->timeStamp())
+                ->add(std::string("display")+buf, standard->display())
+                ->add(std::string("control")+buf, standard->control());
+    }
+    return builder;
+}
+
+void buildMiss(size_t width)
+{
+    testDiag("%s width=%zu", CURRENT_FUNCTION, width);
     TimeIt record;
 
     pvd::FieldCreatePtr create(pvd::getFieldCreate());
-    pvd::StandardFieldPtr standard(pvd::getStandardField());
 
     for(size_t i=0; i<1000; i++) {
         // unique name each time to (partially) defeat caching
@@ -58,13 +74,12 @@ void buildMiss()
 
         record.start();
 
-        pvd::FieldConstPtr fld(create->createFieldBuilder()
-                               ->setId(buf)
-                               ->add("value", pvd::pvInt)
-                               ->addNestedStructure(buf)
-                                   ->add("value", pvd::pvString)
-                               ->endNested()
-                               ->add("display", standard->display())
+        pvd::FieldConstPtr fld(addMeta(create->createFieldBuilder()
+                                       ->setId(buf)
+                                       ->add("value", pvd::pvInt)
+                                       ->addNestedStructure(buf)
+                                           ->add("value", pvd::pvString)
+                                       ->endNested(), width)
                                ->createStructure());
         record.end();
     }
@@ -72,32 +87,29 @@ void buildMiss()
     record.report("us", 1e-6);
 }
 
-void buildHit()
+void buildHit(size_t width)
 {
-    testDiag("%s", CURRENT_FUNCTION);
+    testDiag("%s width=%zu", CURRENT_FUNCTION, width);
     TimeIt record;
 
     pvd::FieldCreatePtr create(pvd::getFieldCreate());
-    pvd::StandardFieldPtr standard(pvd::getStandardField());
 
-    pvd::FieldConstPtr fld(create->createFieldBuilder()
-                           ->add("value", pvd::pvInt)
-                           ->addNestedStructure("foo")
-                               ->add("field", pvd::pvString)
-                           ->endNested()
-                           ->add("display", standard->display())
+    pvd::FieldConstPtr fld(addMeta(create->createFieldBuilder()
+                                   ->add("value", pvd::pvInt)
+                                   ->addNestedStructure("foo")
+                                       ->add("field", pvd::pvString)
+                                   ->endNested(), width)
                            ->createStructure());
 
     for(size_t i=0; i<1000; i++) {
 
         record.start();
 
-        pvd::FieldConstPtr fld(create->createFieldBuilder()
-                               ->add("value", pvd::pvInt)
-                               ->addNestedStructure("foo")
-                                   ->add("field", pvd::pvString)
-                               ->endNested()
-                               ->add("display", standard->display())
+        pvd::FieldConstPtr fld(addMeta(create->createFieldBuilder()
+                                       ->add("value", pvd::pvInt)
+                                       ->addNestedStructure("foo")
+                                           ->add("field", pvd::pvString)
+                                       ->endNested(), width)
                                ->createStructure());
         record.end();
     }
@@ -105,11 +117,41 @@ void buildHit()
     record.report("us", 1e-6);
 }
 
+void buildPV(size_t width, bool flat)
+{
+    testDiag("%s width=%zu flat=%c", CURRENT_FUNCTION, width, flat ? 'Y' : 'N');
+    TimeIt record;
+
+    pvd::PVDataCreatePtr create(pvd::getPVDataCreate());
+
+    pvd::StructureConstPtr type(addMeta(pvd::getFieldCreate()->createFieldBuilder()
+                                        ->add("value", pvd::pvDouble), width)
+                                ->createStructure());
+
+    for(size_t i=0; i<1000; i++) {
+
+        record.start();
+
+        pvd::PVStructurePtr value(flat ? create->createPVStructureFlat(type) : create->createPVStructure(type));
+        value.reset();
+
+        record.end();
+    }
+
+    record.report("us", 1e-6);
+}
+
 } // namespace
 
 MAIN(performStruct) {
     testPlan(0);
-    buildMiss();
-    buildHit();
+    buildMiss(1);
+    buildHit(1);
+    buildMiss(10);
+    buildHit(10);
+    buildPV(1, false);
+    buildPV(1, true);
+    buildPV(10, false);
+    buildPV(10, true);
     return testDone();
 }
@@ -0,0 +1,115 @@
+// Attempt to quantify contention on the FieldCreate de-duplication cache
+// when several threads create and destroy introspection types concurrently.
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+
+#include <vector>
+
+#include <epicsEvent.h>
+#include <testMain.h>
+#include <epicsUnitTest.h>
+
+#include <pv/current_function.h>
+#include <pv/pvData.h>
+#include <pv/standardField.h>
+#include <pv/thread.h>
+#include <pv/sharedPtr.h>
+
+namespace {
+
+namespace pvd = epics::pvData;
+
+double now()
+{
+    struct timespec T;
+    clock_gettime(CLOCK_MONOTONIC, &T);
+    return T.tv_sec + T.tv_nsec*1e-9;
+}
+
+struct Worker {
+    const size_t id;
+    const size_t count;
+    epicsEvent& go;
+    double elapsed;
+
+    Worker(size_t id, size_t count, epicsEvent& go) :id(id), count(count), go(go), elapsed(0.0) {}
+
+    void run()
+    {
+        pvd::FieldCreatePtr create(pvd::getFieldCreate());
+        pvd::StandardFieldPtr standard(pvd::getStandardField());
+
+        go.wait();
+        go.signal(); // wake the next worker
+
+        double start = now();
+
+        for(size_t i=0; i<count; i++) {
+            // alternate between a type shared by all workers (cache hit)
+            // and one unique to this worker and iteration (miss, then erase on destroy)
+            char buf[32];
+            if(i&1)
+                sprintf(buf, "worker%zu_%zu", id, i);
+            else
+                sprintf(buf, "common");
+
+            pvd::StructureConstPtr type(create->createFieldBuilder()
+                                        ->setId(buf)
+                                        ->add("value", pvd::pvDouble)
+                                        ->add("alarm", standard->alarm())
+                                        ->add("timeStamp", standard->timeStamp())
+                                        ->addNestedStructure("extra")
+                                            ->add("name", pvd::pvString)
+                                            ->addArray("data", pvd::pvInt)
+                                        ->endNested()
+                                        ->createStructure());
+        }
+
+        elapsed = now() - start;
+    }
+};
+
+void buildDrop(size_t nthreads)
+{
+    testDiag("%s nthreads=%zu", CURRENT_FUNCTION, nthreads);
+
+    const size_t count = 20000;
+    epicsEvent go;
+
+    std::vector<std::tr1::shared_ptr<Worker> > workers(nthreads);
+    std::vector<std::tr1::shared_ptr<pvd::Thread> > threads(nthreads);
+
+    for(size_t i=0; i<nthreads; i++) {
+        workers[i].reset(new Worker(i, count, go));
+        threads[i].reset(new pvd::Thread(pvd::Thread::Config(workers[i].get(), &Worker::run)
+                                         <<"worker"<<i));
+    }
+
+    double start = now();
+    go.signal();
+
+    for(size_t i=0; i<nthreads; i++)
+        threads[i]->exitWait();
+
+    double total = now() - start;
+
+    double worst = 0.0;
+    for(size_t i=0; i<nthreads; i++)
+        if(workers[i]->elapsed > worst)
+            worst = workers[i]->elapsed;
+
+    printf("# %zu threads x %zu types  total %f s  slowest thread %f us/type  throughput %f types/us\n",
+           nthreads, count, total, worst/count*1e6, nthreads*count/total*1e-6);
+}
+
+} // namespace
+
+MAIN(performStructMT) {
+    testPlan(0);
+    buildDrop(1);
+    buildDrop(2);
+    buildDrop(4);
+    buildDrop(8);
+    return testDone();
+}
@@ -117,13 +117,110 @@ static void test()
     printf("testBitSetUtil PASSED\n");
 }
 
+// The previous recursive implementation of BitSetUtil::compress()
+static bool referenceCompress(const PVField& pvField, BitSet& bitSet, int32 initialOffset)
+{
+    int32 offset = initialOffset;
+    int32 nbits = static_cast<int32>(pvField.getNumberFields());
+    if(nbits==1) return bitSet.get(offset);
+    int32 nextSetBit = bitSet.nextSetBit(offset);
+    if(nextSetBit>=(offset+nbits)) return false;
+    if(nextSetBit<0) return false;
+    if(bitSet.get(offset)) {
+        for(int32 i=offset+1; i<offset+nbits; i++) bitSet.clear(i);
+        return true;
+    }
+
+    bool atLeastOneBitSet = false;
+    bool allBitsSet = true;
+    const PVStructure& pvStructure = static_cast<const PVStructure&>(pvField);
+    const PVFieldPtrArray& subs = pvStructure.getPVFields();
+    for(size_t i=0; i<subs.size(); i++) {
+        offset = static_cast<int32>(subs[i]->getFieldOffset());
+        if(referenceCompress(*subs[i], bitSet, offset)) {
+            atLeastOneBitSet = true;
+            if(!bitSet.get(offset))
+                allBitsSet = false;
+        } else {
+            allBitsSet = false;
+        }
+    }
+    if(allBitsSet) {
+        for(int32 i=initialOffset+1; i<initialOffset+nbits; i++)
+            bitSet.clear(i);
+        bitSet.set(initialOffset);
+    }
+    return atLeastOneBitSet;
+}
+
+static void testRanges()
+{
+    testDiag("testRanges()");
+
+    StructureConstPtr type(getFieldCreate()->createFieldBuilder()
+                           ->add("a", pvInt)
+                           ->addNestedStructure("b")
+                               ->add("c", pvInt)
+                               ->addNestedStructure("d")
+                                   ->add("e", pvInt)
+                               ->endNested()
+                               ->addNestedStructure("empty")
+                               ->endNested()
+                           ->endNested()
+                           ->add("f", pvInt)
+                           ->add("g", standardField->alarm())
+                           ->createStructure());
+    PVStructurePtr inst(type->build());
+
+    // all structures in offset order
+    std::vector<PVStructure*> structs;
+    structs.push_back(inst.get());
+    structs.push_back(inst->getSubFieldT<PVStructure>("b").get());
+    structs.push_back(inst->getSubFieldT<PVStructure>("b.d").get());
+    structs.push_back(inst->getSubFieldT<PVStructure>("b.empty").get());
+    structs.push_back(inst->getSubFieldT<PVStructure>("g").get());
+
+    const Structure::ranges_t& ranges = type->getStructureRanges();
+    bool match = ranges.size()==structs.size();
+    for(size_t i=0; match && i<ranges.size(); i++) {
+        match &= ranges[i].first==structs[i]->getFieldOffset()
+                && ranges[i].second==structs[i]->getNextFieldOffset();
+    }
+    testOk(match, "getStructureRanges() matches field offsets");
+
+    // compare with reference for many combinations of bits
+    const uint32 nfields = inst->getNumberFields();
+    srand(1234);
+    bool ok = true;
+    for(unsigned n=0; n<1000u; n++) {
+        BitSet input;
+        for(uint32 i=0; i<nfields; i++) {
+            if(rand()%2)
+                input.set(i);
+        }
+
+        BitSet expect(input), actual(input);
+        bool eret = referenceCompress(*inst, expect, 0);
+        bool aret = BitSetUtil::compress(actual, *type);
+        if(eret!=aret || expect!=actual) {
+            std::ostringstream msg;
+            msg<<"input "<<input<<" expect "<<expect<<" "<<eret<<" actual "<<actual<<" "<<aret;
+            testDiag("%s", msg.str().c_str());
+            ok = false;
+            break;
+        }
+    }
+    testOk(ok, "compress() matches reference");
+}
+
 MAIN(testBitSetUtil)
 {
-    testPlan(5);
+    testPlan(7);
     fieldCreate = getFieldCreate();
     pvDataCreate = getPVDataCreate();
     standardField = getStandardField();
     standardPVField = getStandardPVField();
     test();
+    testRanges();
     return testDone();
 }
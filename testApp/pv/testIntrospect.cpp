@@ -406,9 +406,92 @@ static void testMapping()
 
 }
 
+static void testDedup()
+{
+    testDiag("testDedup");
+
+    StructureConstPtr A(fieldCreate->createFieldBuilder()
+                        ->setId("foo")
+                        ->add("x", pvInt)
+                        ->add("alarm", standardField->alarm())
+                        ->addBoundedArray("y", pvDouble, 4)
+                        ->createStructure());
+    // identical definitions share an instance
+    StructureConstPtr B(fieldCreate->createFieldBuilder()
+                        ->setId("foo")
+                        ->add("x", pvInt)
+                        ->add("alarm", standardField->alarm())
+                        ->addBoundedArray("y", pvDouble, 4)
+                        ->createStructure());
+    testOk1(A.get()==B.get());
+
+    // different ID
+    StructureConstPtr C(fieldCreate->createFieldBuilder()
+                        ->setId("bar")
+                        ->add("x", pvInt)
+                        ->add("alarm", standardField->alarm())
+                        ->addBoundedArray("y", pvDouble, 4)
+                        ->createStructure());
+    testOk1(A.get()!=C.get());
+
+    // different member name
+    StructureConstPtr D(fieldCreate->createFieldBuilder()
+                        ->setId("foo")
+                        ->add("z", pvInt)
+                        ->add("alarm", standardField->alarm())
+                        ->addBoundedArray("y", pvDouble, 4)
+                        ->createStructure());
+    testOk1(A.get()!=D.get());
+
+    // different member order
+    StructureConstPtr E(fieldCreate->createFieldBuilder()
+                        ->setId("foo")
+                        ->add("alarm", standardField->alarm())
+                        ->add("x", pvInt)
+                        ->addBoundedArray("y", pvDouble, 4)
+                        ->createStructure());
+    testOk1(A.get()!=E.get());
+
+    // different array bound
+    StructureConstPtr F(fieldCreate->createFieldBuilder()
+                        ->setId("foo")
+                        ->add("x", pvInt)
+                        ->add("alarm", standardField->alarm())
+                        ->addBoundedArray("y", pvDouble, 5)
+                        ->createStructure());
+    testOk1(A.get()!=F.get());
+
+    // bounded vs. fixed vs. variable size arrays
+    testOk1(fieldCreate->createBoundedScalarArray(pvDouble, 4).get()
+            !=fieldCreate->createFixedScalarArray(pvDouble, 4).get());
+    testOk1(fieldCreate->createBoundedScalarArray(pvDouble, 4).get()
+            !=fieldCreate->createScalarArray(pvDouble).get());
+
+    // string bound
+    testOk1(fieldCreate->createBoundedString(4).get()
+            ==fieldCreate->createBoundedString(4).get());
+    testOk1(fieldCreate->createBoundedString(4).get()
+            !=fieldCreate->createBoundedString(5).get());
+    testOk1(fieldCreate->createBoundedString(4).get()
+            !=fieldCreate->createScalar(pvString).get());
+
+    // structure vs. union with the same members
+    UnionConstPtr U(fieldCreate->createFieldBuilder()
+                    ->setId("foo")
+                    ->add("x", pvInt)
+                    ->add("alarm", standardField->alarm())
+                    ->addBoundedArray("y", pvDouble, 4)
+                    ->createUnion());
+    testOk1(static_cast<const void*>(A.get())!=static_cast<const void*>(U.get()));
+    testOk1(fieldCreate->createStructureArray(A).get()
+            ==fieldCreate->createStructureArray(B).get());
+    testOk1(fieldCreate->createStructureArray(A).get()
+            !=fieldCreate->createStructureArray(C).get());
+}
+
 MAIN(testIntrospect)
 {
-    testPlan(358);
+    testPlan(371);
     fieldCreate = getFieldCreate();
     pvDataCreate = getPVDataCreate();
     standardField = getStandardField();
@@ -419,5 +502,6 @@ MAIN(testIntrospect)
     testBoundedString();
     testError();
     testMapping();
+    testDedup();
     return testDone();
 }
@@ -766,9 +766,160 @@ static void testSubField()
     testEqual(value->getSubField(9), PVFieldPtr());
 }
 
+static void testFieldPath()
+{
+    testDiag("testFieldPath()");
+
+    PVStructurePtr value(ValueBuilder()
+                         .add<pvInt>("a", 0)
+                         .addNested("B")
+                            .add<pvInt>("b", 0)
+                            .addNested("C")
+                                .add<pvInt>("c", 0)
+                                .add<pvInt>("d", 0)
+                            .endNested()
+                            .add<pvInt>("e", 0)
+                         .endNested()
+                         .add<pvInt>("z", 0)
+                         .buildPVStructure());
+    StructureConstPtr type(value->getStructure());
+
+#define CHECK(FLD) { FieldPath P(type, FLD); \
+    testEqual(P.getFieldOffset(), value->getSubFieldT(FLD)->getFieldOffset()); \
+    testOk1(value->getSubFieldT(P)==value->getSubFieldT(FLD)); \
+    testOk1(P.getField()==value->getSubFieldT(FLD)->getField()); }
+    CHECK("a");
+    CHECK("B");
+    CHECK("B.b");
+    CHECK("B.C");
+    CHECK("B.C.c");
+    CHECK("B.C.d");
+    CHECK("B.e");
+    CHECK("z");
+#undef CHECK
+
+    testThrows(std::runtime_error, FieldPath(type, "nonexistent"));
+    testThrows(std::runtime_error, FieldPath(type, "B.nonexistent"));
+    testThrows(std::runtime_error, FieldPath(type, "a.b"));
+    testThrows(std::runtime_error, FieldPath(type, ""));
+
+    FieldPath D(type, "B.C.d");
+
+    // reuse with another instance of the same type
+    PVStructurePtr other(type->build());
+    testOk1(other->getSubFieldT<PVInt>(D)==other->getSubFieldT<PVInt>("B.C.d"));
+
+    // not usable with a different type
+    PVStructurePtr sub(value->getSubFieldT<PVStructure>("B"));
+    testOk1(!sub->getSubField(D));
+    testThrows(std::runtime_error, sub->getSubFieldT(D));
+    testOk1(!value->getSubField(FieldPath()));
+
+    // wrong leaf type
+    testOk1(!value->getSubField<PVDouble>(D));
+    testThrows(std::runtime_error, value->getSubFieldT<PVDouble>(D));
+
+    // typed accessors
+    FieldAccessor<PVInt> acc(type, "B.C.d");
+    testEqual(acc.getFieldOffset(), D.getFieldOffset());
+    testOk1(acc.get(*value)==value->getSubFieldT<PVInt>("B.C.d").get());
+    acc(*value).put(42);
+    testEqual(value->getSubFieldT<PVInt>("B.C.d")->get(), 42);
+    testEqual(acc(*other).get(), 0);
+    testOk1(!acc.get(*sub));
+    testThrows(std::runtime_error, acc(*sub));
+    testThrows(std::runtime_error, FieldAccessor<PVDouble>(type, "B.C.d"));
+    testThrows(std::runtime_error, FieldAccessor<PVInt>(type, "B"));
+    testOk1(FieldAccessor<PVStructure>(type, "B").get(*value)==sub.get());
+    testOk1(FieldAccessor<PVScalar>(type, "a").get(*value)==value->getSubFieldT("a").get());
+
+    {
+        StructureConstPtr type2(getFieldCreate()->createFieldBuilder()
+                                ->add("s", pvString)
+                                ->addArray("arr", pvDouble)
+                                ->addNestedStructureArray("sarr")
+                                    ->add("x", pvInt)
+                                ->endNested()
+                                ->addNestedUnion("u")
+                                    ->add("x", pvInt)
+                                ->endNested()
+                                ->createStructure());
+        testOk1(FieldAccessor<PVString>(type2, "s").valid());
+        testOk1(FieldAccessor<PVScalarValue<std::string> >(type2, "s").valid());
+        testOk1(FieldAccessor<PVField>(type2, "s").valid());
+        testThrows(std::runtime_error, FieldAccessor<PVDouble>(type2, "s"));
+        testOk1(FieldAccessor<PVDoubleArray>(type2, "arr").valid());
+        testOk1(FieldAccessor<PVScalarArray>(type2, "arr").valid());
+        testThrows(std::runtime_error, FieldAccessor<PVIntArray>(type2, "arr"));
+        testOk1(FieldAccessor<PVStructureArray>(type2, "sarr").valid());
+        testOk1(FieldAccessor<PVArray>(type2, "sarr").valid());
+        testThrows(std::runtime_error, FieldAccessor<PVScalarArray>(type2, "sarr"));
+        testOk1(FieldAccessor<PVUnion>(type2, "u").valid());
+        testThrows(std::runtime_error, FieldAccessor<PVUnionArray>(type2, "u"));
+    }
+
+    // Structure name lookup
+    testEqual(type->getFieldIndex("z"), 2u);
+    testEqual(type->getFieldIndex("zz"), size_t(-1));
+    testEqual(type->getFieldIndex("B.C", 1), 0u);
+    testOk1(!type->getField("C"));
+}
+
+static void testFlat()
+{
+    testDiag("testFlat()");
+
+    StructureConstPtr type(getFieldCreate()->createFieldBuilder()
+                           ->add("value", pvDouble)
+                           ->add("alarm", standardField->alarm())
+                           ->add("timeStamp", standardField->timeStamp())
+                           ->add("display", standardField->display())
+                           ->addArray("arr", pvInt)
+                           ->add("any", getFieldCreate()->createVariantUnion())
+                           ->addNestedStructure("deep")
+                               ->addNestedStructure("deeper")
+                                   ->add("name", pvString)
+                               ->endNested()
+                           ->endNested()
+                           ->createStructure());
+
+    PVStructurePtr flat(pvDataCreate->createPVStructureFlat(type));
+    PVStructurePtr normal(pvDataCreate->createPVStructure(type));
+
+    testOk1(flat->getStructure()==type);
+    testEqual(flat->getNumberFields(), normal->getNumberFields());
+    testEqual(*flat, *normal);
+
+    flat->getSubFieldT<PVDouble>("value")->put(4.5);
+    flat->getSubFieldT<PVInt>("alarm.severity")->put(2);
+    flat->getSubFieldT<PVString>("deep.deeper.name")->put("a longer string which can't be stored inline");
+    {
+        PVIntArray::svector arr(2, 7);
+        flat->getSubFieldT<PVIntArray>("arr")->replace(freeze(arr));
+    }
+    flat->getSubFieldT<PVUnion>("any")->set(pvDataCreate->createPVScalar(pvString));
+
+    normal->copy(*flat);
+    testEqual(*flat, *normal);
+    testEqual(normal->getSubFieldT<PVDouble>("value")->get(), 4.5);
+
+    PVStructurePtr flat2(pvDataCreate->createPVStructureFlat(type));
+    flat2->copy(*normal);
+    testEqual(*flat2, *flat);
+
+    testOk1(flat->getSubFieldT<PVStructure>("deep.deeper")->getParent()==flat->getSubFieldT<PVStructure>("deep").get());
+    testEqual(flat->getSubFieldT("deep.deeper.name")->getFullName(), "deep.deeper.name");
+
+    // a sub-field may outlive the top structure
+    PVStringPtr name(flat->getSubFieldT<PVString>("deep.deeper.name"));
+    flat.reset();
+    flat2.reset();
+    testEqual(name->get(), "a longer string which can't be stored inline");
+}
+
 MAIN(testPVData)
 {
-    testPlan(271);
+    testPlan(340);
     try{
         fieldCreate = getFieldCreate();
         pvDataCreate = getPVDataCreate();
@@ -785,6 +936,8 @@ MAIN(testPVData)
         testFieldAccess();
         testAnyScalar();
         testSubField();
+        testFieldPath();
+        testFlat();
     }catch(std::exception& e){
         PRINT_EXCEPTION(e);
         testAbort("Unhandled Exception: %s", e.what());
@@ -0,0 +1,118 @@
+/*
+ * Copyright information and license terms for this software can be
+ * found in the file LICENSE that is included with the distribution
+ */
+
+#include <testMain.h>
+
+#include <pv/pvUnitTest.h>
+#include <pv/pvIntrospect.h>
+#include <pv/pvData.h>
+#include <pv/standardField.h>
+#include <pv/pvStructurePool.h>
+
+namespace pvd = epics::pvData;
+
+namespace {
+
+pvd::StructureConstPtr makeType()
+{
+    return pvd::getFieldCreate()->createFieldBuilder()
+            ->add("value", pvd::pvDouble)
+            ->addArray("arr", pvd::pvInt)
+            ->add("alarm", pvd::getStandardField()->alarm())
+            ->createStructure();
+}
+
+void testRecycle()
+{
+    testDiag("testRecycle()");
+
+    pvd::PVStructurePool pool(makeType(), 2u);
+
+    testEqual(pool.freeCount(), 0u);
+    testEqual(pool.getHighWater(), 2u);
+
+    pvd::PVStructurePtr A(pool.get());
+    testOk1(A->getStructure()==pool.getStructure());
+
+    A->getSubFieldT<pvd::PVDouble>("value")->put(4.5);
+    A->getSubFieldT<pvd::PVString>("alarm.message")->put("bad");
+    {
+        pvd::PVIntArray::svector arr(2, 1);
+        A->getSubFieldT<pvd::PVIntArray>("arr")->replace(pvd::freeze(arr));
+    }
+
+    pvd::PVStructure *raw = A.get();
+    A.reset();
+    testEqual(pool.freeCount(), 1u);
+
+    A = pool.get();
+    testOk1(A.get()==raw);
+    testEqual(pool.freeCount(), 0u);
+    // reset to defaults
+    testEqual(A->getSubFieldT<pvd::PVDouble>("value")->get(), 0.0);
+    testEqual(A->getSubFieldT<pvd::PVString>("alarm.message")->get(), "");
+    testEqual(A->getSubFieldT<pvd::PVIntArray>("arr")->getLength(), 0u);
+    // shared_from_this() refers to the new reference
+    testOk1(A->getSubFieldT("value")->getParent()->shared_from_this()==A);
+
+    // high water mark
+    pvd::PVStructurePtr B(pool.get()), C(pool.get());
+    testOk1(B.get()!=C.get() && A.get()!=B.get());
+    A.reset();
+    B.reset();
+    C.reset();
+    testEqual(pool.freeCount(), 2u);
+
+    pool.setHighWater(1u);
+    testEqual(pool.freeCount(), 1u);
+
+    // immutable instances are not recycled
+    A = pool.get();
+    A->setImmutable();
+    A.reset();
+    testEqual(pool.freeCount(), 0u);
+}
+
+void testNoReset()
+{
+    testDiag("testNoReset()");
+
+    pvd::PVStructurePool pool(makeType(), 2u, false);
+
+    pvd::PVStructurePtr A(pool.get());
+    A->getSubFieldT<pvd::PVDouble>("value")->put(4.5);
+    A.reset();
+
+    A = pool.get();
+    testEqual(A->getSubFieldT<pvd::PVDouble>("value")->get(), 4.5);
+}
+
+void testOutlive()
+{
+    testDiag("testOutlive()");
+
+    pvd::PVStructurePtr A;
+    {
+        pvd::PVStructurePool pool(makeType());
+        A = pool.get();
+        pvd::PVStructurePtr B(pool.get());
+    }
+    // pool is gone, A is still valid, and will be destroyed on release
+    A->getSubFieldT<pvd::PVDouble>("value")->put(1.0);
+    testEqual(A->getSubFieldT<pvd::PVDouble>("value")->get(), 1.0);
+    A.reset();
+    testPass("released after pool destroyed");
+}
+
+} // namespace
+
+MAIN(testPVStructurePool)
+{
+    testPlan(17);
+    testRecycle();
+    testNoReset();
+    testOutlive();
+    return testDone();
+}
@@ -42,6 +42,7 @@ int testOperators(void);
 int testPVData(void);
 int testPVScalarArray(void);
 int testPVStructureArray(void);
+int testPVStructurePool(void);
 int testPVType(void);
 int testPVUnion(void);
 int testStandardField(void);
@@ -60,6 +61,7 @@ void pvDataAllTests(void)
     runTest(testPVData);
     runTest(testPVScalarArray);
     runTest(testPVStructureArray);
+    runTest(testPVStructurePool);
     runTest(testPVType);
     runTest(testPVUnion);
     runTest(testStandardField);